@@ -0,0 +1,345 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for autosaving the level being edited to a recovery file
+*/
+
+#include "autosave.hpp"
+#include "../lem3edit.hpp"
+#include "../level.hpp"
+#include "../transaction.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <experimental/filesystem>
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+#define AUTOSAVE_INTERVAL 30000 // milliseconds
+#define RECOVERY_EXTENSION ".autosave"
+#define RECOVERY_MAGIC "L3AS"
+
+Autosave::Autosave(void) : lastTick(0), worker(NULL), mutex(NULL), wake(NULL), idle(NULL), pending(false), busy(false), quitting(false), lastHash(0), savedHash(0), recovered(false)
+{
+	/* nothing to do */
+}
+
+Autosave::~Autosave(void)
+{
+	/* stop() must already have been called */
+}
+
+fs::path Autosave::recoveryPath(const fs::path levelPath)
+{
+	fs::path p = levelPath;
+	p += RECOVERY_EXTENSION;
+	return p;
+}
+
+bool Autosave::hasRecovery(const fs::path levelPath)
+{
+	return fs::exists(recoveryPath(levelPath));
+}
+
+void Autosave::discardRecovery(const fs::path levelPath)
+{
+	error_code ec;
+	fs::remove(recoveryPath(levelPath), ec);
+}
+
+void Autosave::takeSnapshot(const Level &level, Snapshot &snapshot) const
+{
+	level.encode_level(snapshot.header);
+	for (int type = 0; type < 3; ++type)
+	{
+		snapshot.object[type] = level.object[type].dense();
+		// The file holds real positions, like a saved level
+		if (level.originX != 0 || level.originY != 0)
+		{
+			for (vector<Level::Object>::iterator i = snapshot.object[type].begin(); i != snapshot.object[type].end(); ++i)
+				*i = level.absolute(*i);
+		}
+	}
+}
+
+// FNV-1a over the header and every object, enough to tell if anything changed since the last write
+Uint64 Autosave::hash(const Snapshot &snapshot)
+{
+	Uint64 h = 14695981039346656037ULL;
+	const Uint64 prime = 1099511628211ULL;
+
+	for (vector<Uint8>::const_iterator i = snapshot.header.begin(); i != snapshot.header.end(); ++i)
+		h = (h ^ *i) * prime;
+	for (int type = 0; type < 3; ++type)
+	{
+		h = (h ^ (Uint64)snapshot.object[type].size()) * prime;
+		for (vector<Level::Object>::const_iterator o = snapshot.object[type].begin(); o != snapshot.object[type].end(); ++o)
+		{
+			h = (h ^ o->id) * prime;
+			h = (h ^ (Uint16)o->x) * prime;
+			h = (h ^ (Uint16)o->y) * prime;
+		}
+	}
+	return h;
+}
+
+void Autosave::start(const Level &level)
+{
+	if (worker != NULL)
+		shutdown();
+
+	levelPath = level.levelPath;
+	lastTick = SDL_GetTicks();
+
+	// Nothing needs recovering until the level differs from how it was loaded
+	Snapshot snapshot;
+	takeSnapshot(level, snapshot);
+	lastHash = hash(snapshot);
+	if (!recovered)
+		savedHash = lastHash;
+	recovered = false;
+
+	pending = false;
+	busy = false;
+	quitting = false;
+	mutex = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	idle = SDL_CreateCond();
+	worker = SDL_CreateThread(workerMain, "autosave", this);
+	if (worker == NULL)
+		SDL_Log("Autosave: Couldn't start worker thread: %s\n", SDL_GetError());
+}
+
+void Autosave::tick(const Level &level)
+{
+	if (worker == NULL || SDL_GetTicks() - lastTick < AUTOSAVE_INTERVAL)
+		return;
+
+	lastTick = SDL_GetTicks();
+	queue(level);
+}
+
+void Autosave::queue(const Level &level)
+{
+	SDL_LockMutex(mutex);
+	takeSnapshot(level, queued);
+	pending = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(mutex);
+}
+
+void Autosave::waitUntilIdle(void)
+{
+	SDL_LockMutex(mutex);
+	while (pending || busy)
+		SDL_CondWait(idle, mutex);
+	SDL_UnlockMutex(mutex);
+}
+
+void Autosave::saved(const Level &level)
+{
+	Snapshot snapshot;
+	takeSnapshot(level, snapshot);
+	savedHash = hash(snapshot);
+
+	if (worker == NULL)
+		return;
+
+	// Let any write in progress finish first so it can't recreate the file afterwards
+	waitUntilIdle();
+	discardRecovery(levelPath);
+	lastHash = savedHash;
+}
+
+bool Autosave::unsaved(const Level &level) const
+{
+	Snapshot snapshot;
+	takeSnapshot(level, snapshot);
+	return hash(snapshot) != savedHash;
+}
+
+void Autosave::stop(const Level &level, bool discard)
+{
+	if (worker == NULL)
+		return;
+
+	if (!discard)
+		queue(level);
+	shutdown();
+
+	if (discard)
+		discardRecovery(levelPath);
+}
+
+void Autosave::shutdown(void)
+{
+	SDL_LockMutex(mutex);
+	quitting = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(mutex);
+	SDL_WaitThread(worker, NULL);
+	worker = NULL;
+
+	SDL_DestroyCond(idle);
+	SDL_DestroyCond(wake);
+	SDL_DestroyMutex(mutex);
+	idle = wake = NULL;
+	mutex = NULL;
+}
+
+int SDLCALL Autosave::workerMain(void *data)
+{
+	Autosave *autosave = (Autosave *)data;
+	Snapshot snapshot;
+
+	SDL_LockMutex(autosave->mutex);
+	while (true)
+	{
+		while (!autosave->pending && !autosave->quitting)
+			SDL_CondWait(autosave->wake, autosave->mutex);
+		if (!autosave->pending)
+			break;
+
+		std::swap(snapshot, autosave->queued);
+		autosave->pending = false;
+		autosave->busy = true;
+		SDL_UnlockMutex(autosave->mutex);
+
+		Uint64 h = hash(snapshot);
+		if (h != autosave->lastHash)
+		{
+			autosave->write(snapshot);
+			autosave->lastHash = h;
+		}
+
+		SDL_LockMutex(autosave->mutex);
+		autosave->busy = false;
+		SDL_CondBroadcast(autosave->idle);
+	}
+	SDL_UnlockMutex(autosave->mutex);
+
+	return 0;
+}
+
+// Recovery file layout: magic, DAT header, then for each layer a 32 bit count followed by OBS records
+void Autosave::write(const Snapshot &snapshot)
+{
+	size_t records = snapshot.object[PERM].size() + snapshot.object[TEMP].size() + snapshot.object[TOOL].size();
+	vector<Uint8> buffer;
+	buffer.reserve(4 + snapshot.header.size() + 3 * 4 + records * Level::OBS_RECORD_SIZE);
+
+	buffer.insert(buffer.end(), RECOVERY_MAGIC, RECOVERY_MAGIC + 4);
+	buffer.insert(buffer.end(), snapshot.header.begin(), snapshot.header.end());
+	for (int type = 0; type < 3; ++type)
+	{
+		Uint32 count = snapshot.object[type].size();
+		size_t at = buffer.size();
+		buffer.resize(at + 4 + count * Level::OBS_RECORD_SIZE);
+		l3_write_le16(&buffer[at], count & 0xFFFF);
+		l3_write_le16(&buffer[at + 2], count >> 16);
+		at += 4;
+		for (vector<Level::Object>::const_iterator o = snapshot.object[type].begin(); o != snapshot.object[type].end(); ++o)
+		{
+			l3_write_le16(&buffer[at], o->id);
+			l3_write_le16(&buffer[at + 2], (Uint16)o->x);
+			l3_write_le16(&buffer[at + 4], (Uint16)o->y);
+			at += Level::OBS_RECORD_SIZE;
+		}
+	}
+
+	// Written aside and renamed so a crash mid write never leaves a broken recovery file
+	const fs::path target = recoveryPath(levelPath);
+	fs::path staged = target;
+	staged += ".new";
+	error_code ec;
+	if (SaveTransaction::writeFileSynced(staged, buffer))
+		fs::rename(staged, target, ec);
+	if (ec)
+		SDL_Log("Autosave: Couldn't write '%s'\n", target.generic_string().c_str());
+	else
+		SDL_Log("Autosaved to '%s'\n", target.generic_string().c_str());
+}
+
+bool Autosave::loadRecovery(Level &level)
+{
+	const fs::path filename = recoveryPath(level.levelPath);
+	ifstream f(filename, ios::binary | ios::ate);
+	if (!f)
+	{
+		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+		return false;
+	}
+
+	streamoff size = f.tellg();
+	f.seekg(0);
+	vector<Uint8> buffer(size > 0 ? (size_t)size : 0);
+	if (!buffer.empty())
+		f.read((char *)&buffer[0], buffer.size());
+	f.close();
+
+	size_t at = 4 + Level::DAT_SIZE;
+	if (buffer.size() < at || !equal(buffer.begin(), buffer.begin() + 4, RECOVERY_MAGIC))
+	{
+		SDL_Log("loadRecovery: '%s' isn't a recovery file\n", filename.generic_string().c_str());
+		return false;
+	}
+
+	// Check the whole file before changing the level
+	vector<Level::Object> object[3];
+	for (int type = 0; type < 3; ++type)
+	{
+		if (buffer.size() < at + 4)
+			return false;
+		Uint32 count = l3_read_le16(&buffer[at]) | (l3_read_le16(&buffer[at + 2]) << 16);
+		at += 4;
+		if ((buffer.size() - at) / Level::OBS_RECORD_SIZE < count)
+		{
+			SDL_Log("loadRecovery: '%s' is truncated\n", filename.generic_string().c_str());
+			return false;
+		}
+
+		object[type].resize(count);
+		for (Uint32 i = 0; i < count; ++i)
+		{
+			object[type][i].id = l3_read_le16(&buffer[at]);
+			object[type][i].x = (Sint16)l3_read_le16(&buffer[at + 2]);
+			object[type][i].y = (Sint16)l3_read_le16(&buffer[at + 4]);
+			at += Level::OBS_RECORD_SIZE;
+		}
+	}
+
+	// The files on disk are still what counts as saved
+	Snapshot onDisk;
+	takeSnapshot(level, onDisk);
+	savedHash = hash(onDisk);
+	recovered = true;
+
+	level.decode_level(&buffer[4]);
+	level.originX = level.originY = 0;
+	for (int type = 0; type < 3; ++type)
+		level.object[type].assign(object[type]);
+
+	SDL_Log("Recovered level from '%s'\n", filename.generic_string().c_str());
+	return true;
+}
@@ -0,0 +1,95 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef AUTOSAVE_HPP
+#define AUTOSAVE_HPP
+
+#include "../level.hpp"
+
+#include "SDL.h"
+
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+// Periodically copies the level being edited and writes it to a recovery file next to it on a worker thread
+class Autosave
+{
+public:
+	// A copy of everything save would write, cheap enough to take on the UI thread
+	class Snapshot
+	{
+	public:
+		std::vector<Uint8> header;
+		std::vector<Level::Object> object[3];
+	};
+
+	void start(const Level &level);
+	void tick(const Level &level);
+	// Writes any last changes and ends the worker thread, deleting the recovery file if discard is set
+	void stop(const Level &level, bool discard);
+	// Call after the level is saved normally, so there is nothing left to recover
+	void saved(const Level &level);
+	// Whether the level differs from how it was last loaded or saved
+	bool unsaved(const Level &level) const;
+
+	static fs::path recoveryPath(const fs::path levelPath);
+	static bool hasRecovery(const fs::path levelPath);
+	// Remembers the level as it was loaded from disk, so the next start() still sees the recovered changes as unsaved
+	bool loadRecovery(Level &level);
+	static void discardRecovery(const fs::path levelPath);
+
+	Autosave(void);
+	~Autosave(void);
+
+private:
+	fs::path levelPath;
+	Uint32 lastTick;
+
+	SDL_Thread *worker;
+	SDL_mutex *mutex;
+	SDL_cond *wake;
+	SDL_cond *idle;
+	bool pending;
+	bool busy;
+	bool quitting;
+	Snapshot queued;
+	// The worker reads and writes this unlocked while busy. The UI thread sets it in start() before
+	// the worker exists and in saved() after waitUntilIdle(); nothing can be queued in between,
+	// since only the UI thread queues work, so the worker is never busy at the same time.
+	Uint64 lastHash;
+	Uint64 savedHash; // the level as it was loaded or last saved, only used on the UI thread
+	bool recovered; // savedHash was taken by loadRecovery, for start() to keep
+
+	void takeSnapshot(const Level &level, Snapshot &snapshot) const;
+	void queue(const Level &level);
+	void waitUntilIdle(void);
+	void shutdown(void);
+	void write(const Snapshot &snapshot);
+
+	static Uint64 hash(const Snapshot &snapshot);
+	static int SDLCALL workerMain(void *data);
+
+	Autosave(const Autosave &);
+	Autosave & operator=(const Autosave &);
+};
+
+#endif // AUTOSAVE_HPP
@@ -30,6 +30,7 @@ This file includes code to deal with the object bar at the bottom of the editor
 
 #include "SDL.h"
 
+#include <algorithm>
 #include <cassert>
 #include <stdlib.h>
 #include <string>
@@ -48,6 +49,7 @@ void Bar::load(void)
 		barTypeCount[i] = style_ptr->object[i].size();
 		barTypeMax[i] = barTypeCount[i] * PIECESIZE;
 	}
+	updatePrefabCount();
 	barScrollX = 0;
 	type = PERM;
 
@@ -70,8 +72,6 @@ void Bar::load(void)
 	loadButtonGraphic(button_delete, "./gfx/delete_up.bmp", NULL);
 	loadButtonGraphic(button_quit, "./gfx/quit_up.bmp", NULL);
 
-	tooltipFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 14);
-
 	setButtonTooltip(button_layerBackground, "Select Background Layer (1)");
 	setButtonTooltip(button_layerTerrain, "Select Terrain Layer (2)");
 	setButtonTooltip(button_layerTool, "Select Tool and Creature Layer (3)");
@@ -87,8 +87,6 @@ void Bar::load(void)
 	setButtonTooltip(button_paste, "Paste Copied Objects (Ctrl+v)");
 	setButtonTooltip(button_delete, "Delete Selected Objects (delete)");
 	setButtonTooltip(button_quit, "Quit level editor. (q)");
-
-	TTF_CloseFont(tooltipFont);
 }
 
 bool Bar::loadButtonGraphic(buttonInfo & button, const char * filePathUp, const char * filePathDown)
@@ -130,7 +128,7 @@ bool Bar::loadButtonGraphic(buttonInfo & button, const char * filePathUp, const
 
 bool Bar::setButtonTooltip(buttonInfo & button, const char * text)
 {
-	button.tooltip = Font::createTextureFromString(tooltipFont, text);
+	button.tooltip = Font::Label(14, text);
 	return true;
 }
 
@@ -177,7 +175,8 @@ void Bar::moveScrollBar(int moveLocationInWindow)
 
 void Bar::changeType(int t)
 {
-	canvas_ptr->layerVisible[t] = true;
+	if (t != PREFABS)
+		canvas_ptr->layerVisible[t] = true;
 	canvas_ptr->redraw = true;
 	if (type == t)
 		return;
@@ -186,11 +185,23 @@ void Bar::changeType(int t)
 	resizeBarScrollRect(g_window.width, g_window.height);
 }
 
+void Bar::updatePrefabCount(void)
+{
+	barTypeCount[PREFABS] = editor_ptr->prefabs.size();
+	// Never empty, so the scroll bar has something to divide by
+	barTypeMax[PREFABS] = std::max(barTypeCount[PREFABS], 1) * PIECESIZE;
+	if (type == PREFABS)
+		resizeBarScrollRect(g_window.width, g_window.height);
+}
+
 int Bar::getPieceIDByScreenPos(int mousePos)
 {
 	unsigned int piece = mousePos + barScrollX - PANEL_WIDTH;
 	piece /= PIECESIZE;
 
+	if (type == PREFABS)
+		return piece < editor_ptr->prefabs.size() ? (int)piece : -1;
+
 	if (piece > style_ptr->object[type].size())
 		return -1;
 	int id = style_ptr->object[type][piece].id;
@@ -212,6 +223,36 @@ void Bar::draw(int mouseX, int mouseY)
 		SDL_RenderFillRect(g_window.screen_renderer, &rPieceSelector);
 	}
 
+	if (type == PREFABS)
+	{ // draw the prefabs, each already drawn into one texture
+		SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
+		int x = PANEL_WIDTH + 1 - (barScrollX % PIECESIZE);
+
+		for (unsigned int n = barScrollX / PIECESIZE; n < editor_ptr->prefabs.size(); ++n)
+		{
+			SDL_Rect rPieceBox;
+			rPieceBox.x = x + 2;
+			rPieceBox.y = canvas_ptr->height + 2;
+			rPieceBox.w = PIECESIZE - 1;
+			rPieceBox.h = PIECESIZE - 1;
+			SDL_RenderDrawRect(g_window.screen_renderer, &rPieceBox);
+
+			const PrefabLibrary::Prefab &prefab = editor_ptr->prefabs.prefabs[n];
+			int pieceZoom = 1;
+			if (prefab.width < 64 && prefab.height < 64)
+				pieceZoom = 2;
+
+			int pieceXOffset = std::max((128 - (prefab.width * pieceZoom)) / 2, 0);
+			int pieceYOffset = std::max((128 - (prefab.height * pieceZoom)) / 2, 0);
+
+			editor_ptr->prefabs.draw(n, x + 4 + pieceXOffset, canvas_ptr->height + 4 + pieceYOffset, pieceZoom, 128);
+			x += PIECESIZE;
+
+			if (x > g_window.width)
+				break;
+		}
+	}
+	else
 	{ // draw the pieces
 		SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 		int pieceStart = barScrollX / PIECESIZE;
@@ -460,8 +501,8 @@ void Bar::drawButton(const buttonInfo & button, buttonState state, int x, int y)
 
 void Bar::drawTooltip(const buttonInfo & button, int x, int y)
 {
-	int tooltipW, tooltipH;
-	SDL_QueryTexture(button.tooltip, NULL, NULL, &tooltipW, &tooltipH);
+	int tooltipW = Font::stringWidth(button.tooltip.size, button.tooltip.text);
+	int tooltipH = Font::lineHeight(button.tooltip.size);
 
 	SDL_Rect tooltipRect;
 	tooltipRect.x = x;
@@ -474,12 +515,7 @@ void Bar::drawTooltip(const buttonInfo & button, int x, int y)
 	SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 	SDL_RenderDrawRect(g_window.screen_renderer, &tooltipRect);
 
-	tooltipRect.x++;
-	tooltipRect.y++;
-	tooltipRect.w -= 2;
-	tooltipRect.h -= 2;
-
-	SDL_RenderCopy(g_window.screen_renderer, button.tooltip, NULL, &tooltipRect);
+	Font::drawString(button.tooltip, tooltipRect.x + 1, tooltipRect.y + 1, Font::LEFT);
 }
 
 void Bar::destroy(void)
@@ -505,5 +541,4 @@ void Bar::destroyButtonTextures(buttonInfo &button)
 {
 	if (button.buttonTexUp != NULL)	SDL_DestroyTexture(button.buttonTexUp);
 	if (button.buttonTexDown != NULL)	SDL_DestroyTexture(button.buttonTexDown);
-	if (button.tooltip != NULL)	SDL_DestroyTexture(button.tooltip);
 }
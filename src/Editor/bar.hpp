@@ -25,6 +25,8 @@
 #define PANEL_WIDTH 150
 #define PIECESIZE 132
 
+#include "../font.hpp"
+
 #include "SDL.h"
 #include "SDL_ttf.h"
 
@@ -39,16 +41,19 @@ public:
 	Canvas * canvas_ptr;
 	Style * style_ptr;
 
+	// The bar shows the pieces of one of the three layers, or the prefab library
+	static const int PREFABS = 3;
+
 	int barScrollX;
-	int barTypeCount[3];
-	int barTypeMax[3];
+	int barTypeCount[4];
+	int barTypeMax[4];
 	int type;
 	SDL_Rect barScrollRect;
 
 	struct buttonInfo {
 		SDL_Texture * buttonTexUp = NULL;
 		SDL_Texture * buttonTexDown = NULL;
-		SDL_Texture * tooltip = NULL;
+		Font::Label tooltip;
 	};
 	enum buttonState { on, off };
 
@@ -68,8 +73,6 @@ public:
 	buttonInfo button_delete;
 	buttonInfo button_quit;
 
-	TTF_Font * tooltipFont;
-
 	void setReferences(Editor * e, Canvas * c, Style * s);
 	void load(void);
 	bool loadButtonGraphic(buttonInfo & button, const char * filePathUp, const char * filePathDown);
@@ -81,7 +84,9 @@ public:
 	void moveScrollBar(int moveLocationInWindow);
 
 	void changeType(int t);
+	void updatePrefabCount(void);
 
+	// For the prefab library this is the prefab's number instead
 	int getPieceIDByScreenPos(int mousePos);
 
 	void draw(int mouseX, int mouseY);
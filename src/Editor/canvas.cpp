@@ -158,6 +158,28 @@ void Canvas::draw()
 	level_area.y = 0 - (scroll_y * zoom) - scrollOffset_y;
 	level_area.w = level_ptr->width*zoom;
 	level_area.h = level_ptr->height*zoom;
+	if (input_ptr->resizingLevel) // show the level as it will be once the border is let go
+	{
+		switch (input_ptr->resizingWhich)
+		{
+		case Editor_input::whichBorder::left:
+			level_area.x += input_ptr->resizingNewPos * zoom;
+			level_area.w -= input_ptr->resizingNewPos * zoom;
+			break;
+		case Editor_input::whichBorder::top:
+			level_area.y += input_ptr->resizingNewPos * zoom;
+			level_area.h -= input_ptr->resizingNewPos * zoom;
+			break;
+		case Editor_input::whichBorder::right:
+			level_area.w = input_ptr->resizingNewPos * zoom;
+			break;
+		case Editor_input::whichBorder::bottom:
+			level_area.h = input_ptr->resizingNewPos * zoom;
+			break;
+		default:
+			break;
+		}
+	}
 
 	if (redraw)
 	{
@@ -171,11 +193,22 @@ void Canvas::draw()
 
 		level_ptr->draw(scroll_x, scrollOffset_x, scroll_y, scrollOffset_y, zoom);
 
-		for (Editor::Selection::const_iterator i = editor_ptr->selection.begin(); i != editor_ptr->selection.end(); ++i)
+		for (Selection::const_iterator i = editor_ptr->selection.begin(); i != editor_ptr->selection.end(); ++i)
 		{
 			Level::Object &o = level_ptr->object[i->type][i->i];
 			int so = style_ptr->object_by_id(i->type, o.id);
-			draw_selection_box((o.x - scroll_x)*zoom - scrollOffset_x, (o.y - scroll_y)*zoom - scrollOffset_y, style_ptr->object[i->type][so].width * 8 * zoom, style_ptr->object[i->type][so].height * 2 * zoom);
+			draw_selection_box((level_ptr->objectX(o) - scroll_x)*zoom - scrollOffset_x, (level_ptr->objectY(o) - scroll_y)*zoom - scrollOffset_y, style_ptr->object[i->type][so].width * 8 * zoom, style_ptr->object[i->type][so].height * 2 * zoom);
+		}
+		if (input_ptr->creatingSelectionBox) // objects the selection box will add
+		{
+			for (Selection::const_iterator i = editor_ptr->preview.begin(); i != editor_ptr->preview.end(); ++i)
+			{
+				if (editor_ptr->selection.contains(*i))
+					continue;
+				Level::Object &o = level_ptr->object[i->type][i->i];
+				int so = style_ptr->object_by_id(i->type, o.id);
+				draw_selection_box((level_ptr->objectX(o) - scroll_x)*zoom - scrollOffset_x, (level_ptr->objectY(o) - scroll_y)*zoom - scrollOffset_y, style_ptr->object[i->type][so].width * 8 * zoom, style_ptr->object[i->type][so].height * 2 * zoom);
+			}
 		}
 
 		SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
@@ -340,6 +373,28 @@ void Canvas::drawHeldObject(int holdingType, int holdingID, int x, int y)
 	style_ptr->draw_object_texture(drawX, drawY, holdingType, drawID, zoom, 0);
 }
 
+void Canvas::drawHeldPrefab(int holdingPrefab, int x, int y)
+{
+	const Clipboard &objects = editor_ptr->prefabs.prefabs[holdingPrefab].objects;
+	int drawX, drawY;
+	if (y < height)
+	{
+		// Lined up the same way stampPrefab will place it
+		drawX = input_ptr->mouse_x - (((input_ptr->mouse_x - objects.originX) % 8) + 8) % 8 - scroll_x;
+		drawX *= zoom;
+		drawX -= scrollOffset_x;
+		drawY = input_ptr->mouse_y - (((input_ptr->mouse_y - objects.originY) % 2) + 2) % 2 - scroll_y;
+		drawY *= zoom;
+		drawY -= scrollOffset_y;
+	}
+	else
+	{
+		drawX = x;
+		drawY = y;
+	}
+	editor_ptr->prefabs.draw(holdingPrefab, drawX, drawY, zoom, 0);
+}
+
 void Canvas::draw_dashed_level_border(borderType type, int pos, int offset, bool highlight)
 {
 	//We have an offset so the lines don't scroll out of synch with the view when scrolling
@@ -63,6 +63,7 @@ public:
 	void draw_selection_box(int x, int y, int w, int h);
 
 	void drawHeldObject(int holdingType, int holdingID, int x, int y);
+	void drawHeldPrefab(int holdingPrefab, int x, int y);
 
 	enum borderType { horizontal, vertical };
 	void draw_dashed_level_border(borderType type, int pos, int offset, bool highlight);
@@ -0,0 +1,173 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for the clipboard shared by every level and every copy of the editor
+*/
+
+#include "clipboard.hpp"
+#include "../lem3edit.hpp"
+#include "../mappedfile.hpp"
+#include "../style.hpp"
+
+#include "SDL.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// "L3CB", version, style, origin x and y, item count
+#define HEADER_SIZE 14
+// type, id, x, y, ordinal, width, height
+#define ITEM_SIZE 11
+#define VERSION 1
+
+fs::path Clipboard::path(void)
+{
+	fs::path clipboardPath = fs::current_path();
+	clipboardPath /= "lem3edit.clipboard";
+	return clipboardPath;
+}
+
+bool Clipboard::save(const fs::path target) const
+{
+	// Written under a temporary name then renamed, so another editor never reads half of it
+	fs::path staged = target;
+	staged += ".new";
+
+	{
+		MappedFile file;
+		if (!file.create(staged, HEADER_SIZE + items.size() * ITEM_SIZE))
+			return false;
+
+		Uint8 *p = file.writableData();
+		memcpy(p, "L3CB", 4);
+		l3_write_le16(p + 4, VERSION);
+		l3_write_le16(p + 6, style);
+		l3_write_le16(p + 8, (Uint16)originX);
+		l3_write_le16(p + 10, (Uint16)originY);
+		l3_write_le16(p + 12, (Uint16)items.size());
+		p += HEADER_SIZE;
+
+		for (vector<Item>::const_iterator i = items.begin(); i != items.end(); ++i, p += ITEM_SIZE)
+		{
+			p[0] = (Uint8)i->type;
+			l3_write_le16(p + 1, i->id);
+			l3_write_le16(p + 3, (Uint16)i->x);
+			l3_write_le16(p + 5, (Uint16)i->y);
+			l3_write_le16(p + 7, i->ordinal);
+			p[9] = i->width;
+			p[10] = i->height;
+		}
+	}
+
+	error_code ec;
+	fs::rename(staged, target, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to write '%s'\n", target.generic_string().c_str());
+		fs::remove(staged, ec);
+		return false;
+	}
+	return true;
+}
+
+bool Clipboard::load(const fs::path source)
+{
+	error_code ec;
+	if (!fs::exists(source, ec))
+		return false;
+
+	MappedFile file;
+	if (!file.open(source))
+		return false;
+
+	const Uint8 *p = file.data();
+	if (file.size() < HEADER_SIZE || memcmp(p, "L3CB", 4) != 0 || l3_read_le16(p + 4) != VERSION)
+	{
+		SDL_Log("Ignoring '%s', it is not a lem3edit clipboard\n", source.generic_string().c_str());
+		return false;
+	}
+
+	const Uint16 count = l3_read_le16(p + 12);
+	if (file.size() < HEADER_SIZE + (size_t)count * ITEM_SIZE)
+	{
+		SDL_Log("Ignoring '%s', it is cut short\n", source.generic_string().c_str());
+		return false;
+	}
+
+	style = l3_read_le16(p + 6);
+	originX = (Sint16)l3_read_le16(p + 8);
+	originY = (Sint16)l3_read_le16(p + 10);
+	p += HEADER_SIZE;
+
+	items.clear();
+	items.reserve(count);
+	for (int i = 0; i < count; ++i, p += ITEM_SIZE)
+	{
+		Item item;
+		item.type = p[0];
+		item.id = l3_read_le16(p + 1);
+		item.x = (Sint16)l3_read_le16(p + 3);
+		item.y = (Sint16)l3_read_le16(p + 5);
+		item.ordinal = l3_read_le16(p + 7);
+		item.width = p[9];
+		item.height = p[10];
+		if (item.type > TOOL)
+			continue;
+		items.push_back(item);
+	}
+	return true;
+}
+
+signed int Clipboard::idInStyle(const Style &s, Uint16 styleNumber, const Item &item) const
+{
+	const vector<Style::Object> &objects = s.object[item.type];
+
+	// Tools and creatures share their ids between styles, and nothing needs to change in the same style
+	if (styleNumber == style || item.type == TOOL)
+	{
+		if (s.object_by_id(item.type, item.id) != -1)
+			return item.id;
+		if (styleNumber == style)
+			return -1;
+	}
+	if (objects.empty())
+		return -1;
+
+	// Otherwise use the piece of the same size nearest to the same place in the list,
+	// or failing that just the piece in the same place
+	int best = -1;
+	for (int i = 0; i < (int)objects.size(); ++i)
+	{
+		if (objects[i].width != item.width || objects[i].height != item.height)
+			continue;
+		if (best == -1 || abs(i - item.ordinal) < abs(best - item.ordinal))
+			best = i;
+	}
+	if (best == -1)
+		best = min((int)item.ordinal, (int)objects.size() - 1);
+
+	return objects[best].id;
+}
@@ -0,0 +1,72 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef CLIPBOARD_HPP
+#define CLIPBOARD_HPP
+
+#include "SDL.h"
+
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Style;
+
+// Copied objects, kept in a small binary file next to lem3edit.ini rather than in memory,
+// so they can be pasted into another level or into another running copy of the editor.
+// Positions are stored relative to the top left of the copied objects, and each object
+// remembers enough about the piece it was in its own style to pick a stand in from another.
+class Clipboard
+{
+public:
+	class Item
+	{
+	public:
+		int type;
+		Uint16 id;
+		Sint16 x, y; // from the origin
+		Uint16 ordinal; // position in the source style's object list
+		Uint8 width, height; // in blocks
+	};
+
+	Uint16 style;
+	Sint16 originX, originY; // where the objects were copied from
+	std::vector<Item> items;
+
+	bool empty(void) const { return items.empty(); }
+	void clear(void) { items.clear(); }
+
+	bool save(void) const { return save(path()); }
+	// Picks up whatever was last copied by any editor, leaving the clipboard alone if nothing was
+	bool load(void) { return load(path()); }
+	// The same format is used for prefabs
+	bool save(const fs::path target) const;
+	bool load(const fs::path source);
+
+	// The id to paste an item as in the given style, or -1 if the style has nothing to stand in for it
+	signed int idInStyle(const Style &s, Uint16 styleNumber, const Item &item) const;
+
+	static fs::path path(void);
+
+	Clipboard(void) : style(0), originX(0), originY(0) { }
+};
+
+#endif // CLIPBOARD_HPP
@@ -23,10 +23,12 @@
  */
 #include "editor.hpp"
 #include "../tinyfiledialogs.h"
+#include "../transaction.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <set>
 #include <experimental/filesystem>
 using namespace std;
 namespace fs = std::experimental::filesystem::v1;
@@ -39,6 +41,9 @@ Editor::Editor(fs::path data)
 	editor_input.setReferences(this, &bar, &canvas, &style, &level);
 	levelProperties.setReferences(this, &bar, &canvas, &level);
 	level.setReferences(&canvas, &style);
+	selection.setLevel(&level);
+	preview.setLevel(&level);
+	grid.setReferences(&level, &style);
 	font.setReferences(&style);
 }
 
@@ -51,6 +56,7 @@ void Editor::resize(int w, int h)
 void Editor::create(const fs::path filename, const tribeName t, const int n)
 {
 	returnMode = MAINMENUMODE;
+	Autosave::discardRecovery(filename);
 	level.newLevel(filename, t, n);
 	initiate();
 	canvas.redraw = true;
@@ -59,7 +65,23 @@ void Editor::create(const fs::path filename, const tribeName t, const int n)
 bool Editor::load(const fs::path filename, programMode modeToReturnTo)
 {
 	returnMode = modeToReturnTo;
+	SaveTransaction::recover(filename.parent_path());
 	level.load(filename);
+
+	if (Autosave::hasRecovery(filename))
+	{
+		int answer = tinyfd_messageBox(
+			"Recover Level?",
+			"This level has unsaved changes from a previous session that didn't close properly. Do you want to recover them?",
+			"yesno",
+			"question",
+			0);
+		if (answer == 1)
+			autosave.loadRecovery(level);
+		else
+			Autosave::discardRecovery(filename);
+	}
+
 	initiate();
 	return canvas.redraw = true;
 }
@@ -68,6 +90,7 @@ void Editor::initiate(void)
 {
 	tribe.load(level.tribe, dataPath);
 	style.load(level.style, tribe.palette, dataPath);
+	prefabs.load(level.levelPath, style, level.style);
 	//font.load("FONT"); //The in-game font. Not very practical for the editor so commented out
 	//font.createFont();
 	bar.load();
@@ -77,14 +100,32 @@ void Editor::initiate(void)
 	gameFrameCount = 0;
 	gameFrameTick = SDL_GetTicks();
 	startCameraOn = false;
+	history.clear();
+	grid.invalidate();
+	previewing = false;
+	preview.clear();
+	autosave.start(level);
+	watcher.start(std::vector<fs::path>(1, level.levelPath.parent_path()));
+	rememberFiles();
 
 	//prevent open file dialog mouse clicks from carrying over once level loaded
 	SDL_PumpEvents();
 	SDL_FlushEvents(SDL_MOUSEMOTION, SDL_MOUSEWHEEL);
 }
 
+bool Editor::save(bool giveFeedback)
+{
+	if (!level.save(giveFeedback))
+		return false;
+	autosave.saved(level);
+	rememberFiles();
+	return true;
+}
+
 void Editor::closeLevel(bool askToSave)
 {
+	// Keep the recovery file if the user never got the choice to save, or saving failed
+	bool discardRecovery = false;
 	if (askToSave)
 	{
 		int answer = tinyfd_messageBox(
@@ -96,21 +137,124 @@ void Editor::closeLevel(bool askToSave)
 		if (answer == 0)
 			return;
 		else if (answer == 1)
-			level.save(false);
+			discardRecovery = save(false);
+		else
+			discardRecovery = true;
 	}
+	autosave.stop(level, discardRecovery);
+	watcher.stop();
 	bar.destroy();
 	style.destroy_all_objects(PERM);
 	style.destroy_all_objects(TEMP);
 	style.destroy_all_objects(TOOL);
-	levelProperties.destroyTextures();
+	prefabs.destroy();
 	selection.clear();
-	clipboard.clear();
 	g_currentMode = returnMode;
 }
 
+fs::path Editor::levelFile(int f) const
+{
+	if (f == 1)
+		return l3_filename_level(level.levelPath.parent_path(), "PERM", level.perm, "OBS");
+	if (f == 2)
+		return l3_filename_level(level.levelPath.parent_path(), "TEMP", level.temp, "OBS");
+	return level.levelPath;
+}
+
+void Editor::rememberFiles(void)
+{
+	for (int f = 0; f < 3; ++f)
+	{
+		std::error_code ec;
+		fileSize[f] = fs::file_size(levelFile(f), ec);
+		fileTime[f] = ec ? 0 : fs::last_write_time(levelFile(f), ec).time_since_epoch().count();
+	}
+}
+
+void Editor::checkFilesChanged(void)
+{
+	std::set<fs::path> changed;
+	if (!watcher.takeChanges(changed))
+		return;
+
+	bool reload[3] = { false, false, false };
+	bool any = false;
+	for (int f = 0; f < 3; ++f)
+	{
+		fs::path file = levelFile(f);
+		if (changed.find(file) == changed.end())
+			continue;
+
+		// a file that was deleted is left as it is in the editor
+		std::error_code ec;
+		uintmax_t size = fs::file_size(file, ec);
+		if (ec)
+			continue;
+		Sint64 time = fs::last_write_time(file, ec).time_since_epoch().count();
+		if (ec || (size == fileSize[f] && time == fileTime[f]))
+			continue;
+
+		reload[f] = any = true;
+	}
+	if (!any)
+		return;
+
+	// only ask when there is something to lose; the undo history can't tell, since
+	// undoing back to the saved level leaves entries to redo and property edits add none
+	if (autosave.unsaved(level))
+	{
+		int answer = tinyfd_messageBox(
+			"Reload Level?",
+			"The level was changed by another program. Reload it and lose your unsaved changes?",
+			"yesno",
+			"question",
+			0);
+		if (answer == 0)
+		{
+			// keep ours, and don't ask again about the same change
+			rememberFiles();
+			return;
+		}
+	}
+
+	// the files hold real positions
+	level.foldOrigin();
+
+	const Uint16 oldTribe = level.tribe, oldStyle = level.style;
+	const Uint16 oldPerm = level.perm, oldTemp = level.temp;
+	if (reload[0])
+	{
+		level.load_level(level.levelPath);
+		reload[1] |= level.perm != oldPerm;
+		reload[2] |= level.temp != oldTemp;
+	}
+	if (reload[1])
+		level.load_objects(PERM, level.levelPath.parent_path(), "PERM", level.perm);
+	if (reload[2])
+		level.load_objects(TEMP, level.levelPath.parent_path(), "TEMP", level.temp);
+	SDL_Log("Reloaded level '%s' after it changed on disk\n", level.levelPath.generic_string().c_str());
+
+	if (level.tribe != oldTribe || level.style != oldStyle)
+	{
+		// new graphics are needed, which is everything initiate does
+		initiate();
+	}
+	else
+	{
+		selection.clear();
+		preview.clear();
+		previewing = false;
+		grid.invalidate();
+		history.clear();
+		rememberFiles();
+	}
+	autosave.saved(level);
+	canvas.redraw = true;
+}
+
 bool Editor::select(signed int x, signed int y, bool modify_selection)
 {
-	Level::Object::Index temp = level.get_object_by_position(x, y);
+	Level::Object::Index temp = grid.pick(x, y, canvas.layerVisible);
 
 	if (temp.i == -1)  // selected nothing
 	{
@@ -121,7 +265,7 @@ bool Editor::select(signed int x, signed int y, bool modify_selection)
 	}
 	else
 	{
-		bool already_selected = selection.find(temp) != selection.end();
+		bool already_selected = selection.contains(temp);
 		if (already_selected)
 		{
 			if (modify_selection)
@@ -163,80 +307,205 @@ bool Editor::select_all(void)
 	for (unsigned int type = 0; type < COUNTOF(level.object); ++type)
 	{
 		if (canvas.layerVisible[type])
-		{
-			for (unsigned int i = 0; i < level.object[type].size(); ++i)
-			{
-				selection.insert(Level::Object::Index(type, i));
-			}
-		}
+			selection.insertAll(type, level.object[type].size());
 	}
 
 	return canvas.redraw = !selection.empty();
 }
 
+// Adds everything touched by the area to the selection
 bool Editor::select_area(const int areaX, const int areaY, const int areaW, const int areaH)
 {
-	vector<int> tmp[3];
+	preview_area(areaX, areaY, areaW, areaH);
+
+	selection.insert(preview.begin(), preview.end());
+	preview.clear();
+	previewing = false;
+
+	canvas.redraw = !selection.empty();
+	return true;
+}
 
-	int x = areaX;
-	int y = areaY;
-	int w = areaW;
-	int h = areaH;
+// Keeps preview up to date with the objects touched by the area while the selection box is dragged.
+// Only objects near the edges that moved since the last call are looked at, so this stays
+// cheap however many objects are in the box.
+bool Editor::preview_area(const int areaX, const int areaY, const int areaW, const int areaH)
+{
+	SDL_Rect area;
+	area.x = areaX;
+	area.y = areaY;
+	area.w = areaW;
+	area.h = areaH;
 	// We want the area to always have x and y be in the top-left corner, with w and h positive
 	if (areaW < 0)
 	{
-		x = areaX + areaW;
-		w = 0 - areaW;
+		area.x = areaX + areaW;
+		area.w = 0 - areaW;
 	}
 	if (areaH < 0)
 	{
-		y = areaY + areaH;
-		h = 0 - areaH;
+		area.y = areaY + areaH;
+		area.h = 0 - areaH;
 	}
+	// The box includes the pixel under the mouse
+	area.w++;
+	area.h++;
+
+	// Anything changed in the level since the last call means starting again
+	if (grid.update())
+		previewing = false;
 
-	for (int i = 0; i < 3; ++i)
+	vector<Level::Object::Index> found;
+	if (!previewing)
 	{
-		if (canvas.layerVisible[i] == false)
-			continue;
+		preview.clear();
+		grid.query(area, NULL, canvas.layerVisible, found);
+	}
+	else
+	{
+		if (area.x == previewArea.x && area.y == previewArea.y && area.w == previewArea.w && area.h == previewArea.h)
+			return false;
+
+		// Only objects in one area but not the other can change, and none of those are inside both
+		SDL_Rect both, either;
+		if (!SDL_IntersectRect(&area, &previewArea, &both))
+			both.w = both.h = 0;
+		SDL_UnionRect(&area, &previewArea, &either);
+		grid.query(either, &both, canvas.layerVisible, found);
+	}
+
+	for (vector<Level::Object::Index>::const_iterator i = found.begin(); i != found.end(); ++i)
+	{
+		if (grid.touches(*i, area))
+			preview.insert(*i);
+		else
+			preview.erase(*i);
+	}
+
+	previewArea = area;
+	previewing = true;
+	return canvas.redraw = true;
+}
+
+bool Editor::copy_selected(void)
+{
+	if (selection.empty())
+		return false;
 
-		tmp[i] = level.get_objects_in_area(x, y, w, h, i);
+	copySelectionTo(clipboard);
+	// Still pasteable from this editor even if the file can't be written
+	clipboard.save();
+	return true;
+}
 
-		for (std::vector<int>::const_reverse_iterator j = tmp[i].rbegin(); j != tmp[i].rend(); ++j)
+void Editor::copySelectionTo(Clipboard &objects)
+{
+	SDL_Rect bounds = selection.bounds(style);
+	objects.clear();
+	objects.style = level.style;
+	objects.originX = bounds.x;
+	objects.originY = bounds.y;
+
+	// Copy in drawing order so pasted objects overlap the same way
+	vector<Level::Object::Index> indexes;
+	selection.sortedIndexes(indexes);
+	for (vector<Level::Object::Index>::const_iterator i = indexes.begin(); i != indexes.end(); ++i)
+	{
+		const Level::Object &o = level.object[i->type][i->i];
+		Clipboard::Item item;
+		item.type = i->type;
+		item.id = o.id;
+		item.x = level.objectX(o) - bounds.x;
+		item.y = level.objectY(o) - bounds.y;
+		item.ordinal = item.width = item.height = 0;
+
+		int so = style.object_by_id(i->type, o.id);
+		if (so != -1)
 		{
-			selection.insert(Level::Object::Index(i, *j));
+			item.ordinal = so;
+			item.width = style.object[i->type][so].width;
+			item.height = style.object[i->type][so].height;
 		}
+		objects.items.push_back(item);
 	}
+}
 
-	canvas.redraw = !selection.empty();
-	return true;
+// Moves value down onto the grid of step sized squares that origin is on
+static int alignTo(int value, int origin, int step)
+{
+	return value - (((value - origin) % step) + step) % step;
 }
 
-bool Editor::copy_selected(void)
+bool Editor::paste(bool atCursor)
 {
-	clipboard.clear();
+	// Another level or another editor may have copied something since
+	clipboard.load();
+	if (clipboard.empty())
+		return false;
 
-	for (Selection::const_iterator i = selection.begin(); i != selection.end(); ++i)
+	int x = clipboard.originX;
+	int y = clipboard.originY;
+	if (atCursor)
 	{
-		clipboard.push_back(pair<Level::Object::Index, Level::Object>(*i, level.object[i->type][i->i]));
+		// Keep the objects lined up on the same 8x2 grid they were copied from
+		x = alignTo(editor_input.mouse_x, clipboard.originX, 8);
+		y = alignTo(editor_input.mouse_y, clipboard.originY, 2);
 	}
 
-	return !clipboard.empty();
+	return placeObjects(clipboard, x, y);
+}
+
+bool Editor::saveSelectionAsPrefab(void)
+{
+	if (selection.empty())
+		return false;
+
+	Clipboard objects;
+	copySelectionTo(objects);
+	if (!prefabs.add(objects, style, level.style))
+		return false;
+
+	bar.updatePrefabCount();
+	return true;
+}
+
+bool Editor::stampPrefab(unsigned int n, int x, int y)
+{
+	if (n >= prefabs.size())
+		return false;
+
+	const Clipboard &objects = prefabs.prefabs[n].objects;
+	return placeObjects(objects, alignTo(x, objects.originX, 8), alignTo(y, objects.originY, 2));
 }
 
-bool Editor::paste(void)
+// Adds copies of the objects with their top left at x, y and selects them
+bool Editor::placeObjects(const Clipboard &objects, int x, int y)
 {
 	selection.clear(); // maybe delete selection instead?
 
-	for (Clipboard::const_iterator i = clipboard.begin(); i != clipboard.end(); ++i)
+	vector<Level::Object::Index> added;
+	vector<Level::Object> placed;
+	for (vector<Clipboard::Item>::const_iterator i = objects.items.begin(); i != objects.items.end(); ++i)
 	{
-		const Level::Object::Index &index = i->first;
+		int id = objects.idInStyle(style, level.style, *i);
+		if (id == -1)
+			continue;
 
-		level.object[index.type].push_back(i->second);
+		Level::Object o;
+		o.id = id;
+		level.placeObject(o, x + i->x, y + i->y);
+		level.object[i->type].push_back(o);
 
-		selection.insert(Level::Object::Index(index.type, level.object[index.type].size() - 1));
+		selection.insert(Level::Object::Index(i->type, level.object[i->type].size() - 1));
+		added.push_back(Level::Object::Index(i->type, level.object[i->type].size() - 1));
+		placed.push_back(level.absolute(o));
 	}
+	if (added.empty())
+		return false;
+	history.recordAdd(added, placed);
+	grid.invalidate();
 
-	return canvas.redraw = !clipboard.empty();
+	return canvas.redraw = true;
 }
 
 bool Editor::addObject(int idToAdd, int typeToAdd, int xToAdd, int yToAdd)
@@ -244,63 +513,40 @@ bool Editor::addObject(int idToAdd, int typeToAdd, int xToAdd, int yToAdd)
 	Level::Object o;
 
 	o.id = idToAdd;
-	o.x = xToAdd;
-	o.y = yToAdd;
+	level.placeObject(o, xToAdd, yToAdd);
 	level.object[typeToAdd].push_back(o);
+	history.recordAdd(vector<Level::Object::Index>(1, Level::Object::Index(typeToAdd, level.object[typeToAdd].size() - 1)), vector<Level::Object>(1, level.absolute(o)));
+	grid.invalidate();
 
 	return canvas.redraw = true;
 }
 
 bool Editor::moveToFront(void)
 {
-	std::vector<int> indexes[COUNTOF(level.object)];
-
-	for (Selection::const_iterator i = selection.begin(); i != selection.end(); ++i)
-	{
-		indexes[i->type].push_back(i->i);
-	}
-	selection.clear();
-
-	for (unsigned int type = 0; type < COUNTOF(level.object); ++type)
-	{
-		std::sort(indexes[type].begin(), indexes[type].end());
-
-		for (unsigned int i = 0; i < indexes[type].size(); i++)
-		{
-			int j = indexes[type][i] - i;
-			level.object[type].push_back(level.object[type][j]);
-			level.object[type].erase(level.object[type].begin() + j);
-
-			selection.insert(Level::Object::Index(type, level.object[type].size() - i - 1));
-		}
-	}
-
-	return canvas.redraw = true;
+	return reorderSelected(true);
 }
 
 bool Editor::moveToBack(void)
 {
-	std::vector<int> indexes[COUNTOF(level.object)];
+	return reorderSelected(false);
+}
 
-	for (Selection::const_iterator i = selection.begin(); i != selection.end(); ++i)
-	{
-		indexes[i->type].push_back(i->i);
-	}
-	selection.clear();
+//Moves the selected objects in front of or behind the rest of their layer with one pass per layer
+bool Editor::reorderSelected(bool toFront)
+{
+	vector<Level::Object::Index> indexes;
+	selection.sortedIndexes(indexes);
+	history.recordReorder(indexes, toFront);
+
+	vector<int> positions[COUNTOF(level.object)];
+	for (vector<Level::Object::Index>::const_iterator i = indexes.begin(); i != indexes.end(); ++i)
+		positions[i->type].push_back(i->i);
 
+	// The selection follows the objects to their new positions by itself
 	for (unsigned int type = 0; type < COUNTOF(level.object); ++type)
 	{
-		std::sort(indexes[type].begin(), indexes[type].end());
-		std::reverse(indexes[type].begin(), indexes[type].end());
-
-		for (unsigned int i = 0; i < indexes[type].size(); i++)
-		{
-			int j = indexes[type][i] + i;
-			level.object[type].insert(level.object[type].begin(), level.object[type][j]);
-			level.object[type].erase(level.object[type].begin() + j + 1);
-
-			selection.insert(Level::Object::Index(type, i));
-		}
+		if (!positions[type].empty())
+			level.reorder_objects(type, positions[type], toFront);
 	}
 
 	return canvas.redraw = true;
@@ -308,22 +554,32 @@ bool Editor::moveToBack(void)
 
 bool Editor::decrease_obj_id(void)
 {
+	vector<Uint16> oldIds, newIds;
 	for (Selection::const_iterator i = selection.begin(); i != selection.end(); ++i)
 	{
 		Level::Object &o = level.object[i->type][i->i];
+		oldIds.push_back(o.id);
 		o.id = style.object_prev_id(i->type, o.id);
+		newIds.push_back(o.id);
 	}
+	history.recordIdChange(vector<Level::Object::Index>(selection.begin(), selection.end()), oldIds, newIds);
+	grid.invalidate();
 
 	return canvas.redraw = true;
 }
 
 bool Editor::increase_obj_id(void)
 {
+	vector<Uint16> oldIds, newIds;
 	for (Selection::const_iterator i = selection.begin(); i != selection.end(); ++i)
 	{
 		Level::Object &o = level.object[i->type][i->i];
+		oldIds.push_back(o.id);
 		o.id = style.object_next_id(i->type, o.id);
+		newIds.push_back(o.id);
 	}
+	history.recordIdChange(vector<Level::Object::Index>(selection.begin(), selection.end()), oldIds, newIds);
+	grid.invalidate();
 
 	return canvas.redraw = true;
 }
@@ -333,8 +589,24 @@ bool Editor::delete_selected(void)
 	if (selection.empty())
 		return false;
 
-	for (Selection::const_reverse_iterator i = selection.rbegin(); i != selection.rend(); ++i)
-		level.object[i->type].erase(level.object[i->type].begin() + i->i);
+	vector<Level::Object::Index> indexes;
+	selection.sortedIndexes(indexes);
+
+	vector<Level::Object> removed;
+	vector<int> positions[COUNTOF(level.object)];
+	for (vector<Level::Object::Index>::const_iterator i = indexes.begin(); i != indexes.end(); ++i)
+	{
+		removed.push_back(level.absolute(level.object[i->type][i->i]));
+		positions[i->type].push_back(i->i);
+	}
+	history.recordDelete(indexes, removed);
+
+	for (unsigned int type = 0; type < COUNTOF(level.object); ++type)
+	{
+		if (!positions[type].empty())
+			level.remove_objects(type, positions[type]);
+	}
+	grid.invalidate();
 
 	selection.clear();
 
@@ -364,10 +636,46 @@ bool Editor::move_selected(signed int delta_x, signed int delta_y)
 		o.x += delta_x * 8;
 		o.y += delta_y * 2;
 	}
+	selection.offsetBounds(delta_x * 8, delta_y * 2);
+	// Every step of a mouse drag is undone together
+	history.recordMove(selection, delta_x * 8, delta_y * 2, editor_input.dragging);
+	grid.invalidate();
+
+	return canvas.redraw = true;
+}
+
+bool Editor::undo(void)
+{
+	vector<Level::Object::Index> affected;
+	if (!history.undo(level, affected))
+		return false;
+	grid.invalidate();
+
+	selection.clear();
+	selection.insert(affected.begin(), affected.end());
+	return canvas.redraw = true;
+}
+
+bool Editor::redo(void)
+{
+	vector<Level::Object::Index> affected;
+	if (!history.redo(level, affected))
+		return false;
+	grid.invalidate();
 
+	selection.clear();
+	selection.insert(affected.begin(), affected.end());
 	return canvas.redraw = true;
 }
 
+void Editor::resizeLevel(int delta_x, int delta_y, bool shiftLevel)
+{
+	history.recordResize(delta_x, delta_y, shiftLevel, level.cameraX, level.cameraY);
+	level.resizeLevel(delta_x, delta_y, shiftLevel);
+	grid.invalidate();
+	selection.invalidateBounds();
+}
+
 bool Editor::toggleCameraVisibility(void)
 {
 	if (startCameraOn)
@@ -21,19 +21,25 @@
 #ifndef EDITOR_HPP
 #define EDITOR_HPP
 
+#include "autosave.hpp"
 #include "bar.hpp"
 #include "canvas.hpp"
+#include "clipboard.hpp"
 #include "input.hpp"
 #include "levelProperties.hpp"
+#include "prefabLibrary.hpp"
+#include "selection.hpp"
+#include "spatialGrid.hpp"
+#include "undo.hpp"
 #include "../del.hpp"
 #include "../level.hpp"
 #include "../style.hpp"
 #include "../tribe.hpp"
+#include "../watcher.hpp"
 #include "../window.hpp"
 
 #include "SDL.h"
 
-#include <set>
 #include <experimental/filesystem>
 
 namespace fs = std::experimental::filesystem::v1;
@@ -45,6 +51,9 @@ public:
 	Canvas canvas;
 	Editor_input editor_input;
 	LevelProperties levelProperties;
+	Autosave autosave;
+	Undo history;
+	FileWatcher watcher;
 
 	Del font;
 
@@ -54,11 +63,14 @@ public:
 
 	fs::path dataPath;
 
-	typedef std::set<Level::Object::Index> Selection;
 	Selection selection;
+	SpatialGrid grid;
+
+	// The objects inside the selection box while it is being dragged out
+	Selection preview;
 
-	typedef std::vector< std::pair<Level::Object::Index, Level::Object> > Clipboard;
 	Clipboard clipboard;
+	PrefabLibrary prefabs;
 
 	Uint32 gameFrameCount;
 	Uint32 gameFrameTick;
@@ -71,26 +83,42 @@ public:
 	bool select_none(void);
 	bool select_all(void);
 	bool select_area(const int areaX, const int areaY, const int width, const int height);
+	bool preview_area(const int areaX, const int areaY, const int width, const int height);
 
 	bool copy_selected(void);
-	bool paste(void);
+	// Pastes at the mouse cursor, or where the objects were copied from
+	bool paste(bool atCursor);
+
+	bool saveSelectionAsPrefab(void);
+	bool stampPrefab(unsigned int n, int x, int y);
 
 	bool addObject(int idToAdd, int typeToAdd, int xToAdd, int yToAdd);
 
 	bool moveToFront(void);
 	bool moveToBack(void);
+	bool reorderSelected(bool toFront);
 
 	bool decrease_obj_id(void);
 	bool increase_obj_id(void);
 	bool delete_selected(void);
 	bool move_selected(signed int delta_x, signed int delta_y);
 
+	bool undo(void);
+	bool redo(void);
+
+	void resizeLevel(int delta_x, int delta_y, bool shiftLevel);
+
+	bool save(bool giveFeedback);
+
 	void create(const fs::path filename, const tribeName t, const int n);
 	bool load(const fs::path filename, programMode modeToReturnTo);
 	void initiate(void);
 
 	void closeLevel(bool askToSave);
 
+	// Reloads the parts of the level another program changed on disk
+	void checkFilesChanged(void);
+
 	bool toggleCameraVisibility(void);
 	bool move_camera(signed int delta_x, signed int delta_y);
 
@@ -101,6 +129,18 @@ private:
 	//this variable tells us what program mode to return to when the editor closes
 	programMode returnMode = MAINMENUMODE;
 
+	SDL_Rect previewArea;
+	bool previewing = false;
+
+	// The DAT, PERM and TEMP files as they were last loaded or saved, so our own saves aren't reloaded
+	uintmax_t fileSize[3];
+	Sint64 fileTime[3];
+	fs::path levelFile(int f) const;
+	void rememberFiles(void);
+
+	void copySelectionTo(Clipboard &objects);
+	bool placeObjects(const Clipboard &objects, int x, int y);
+
 	/*Editor(const Editor &);
 	Editor & operator=(const Editor &);*/
 };
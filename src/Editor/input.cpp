@@ -59,6 +59,11 @@ void Editor_input::load(void)
 
 	holdingID = -1;
 	holdingType = -1;
+	holdingPrefab = -1;
+
+	stamping = false;
+	stampX = stampY = 0;
+	stamped.clear();
 
 	movingView = false;
 
@@ -115,10 +120,15 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 		{
 			canvas_ptr->scroll(mouse_prev_x - mouse_x_window, mouse_prev_y - mouse_y_window, false);
 		}
+		if (e.state & SDL_BUTTON(SDL_BUTTON_LEFT) && stamping)
+		{
+			stampAt(mouse_x, mouse_y);
+		}
 		if (e.state & SDL_BUTTON(SDL_BUTTON_LEFT) && creatingSelectionBox)
 		{
 			creatingSelectionBoxCurrentX = mouse_x;
 			creatingSelectionBoxCurrentY = mouse_y;
+			editor_ptr->preview_area(creatingSelectionBoxStartX, creatingSelectionBoxStartY, creatingSelectionBoxCurrentX - creatingSelectionBoxStartX, creatingSelectionBoxCurrentY - creatingSelectionBoxStartY);
 			canvas_ptr->redraw = true;
 		}
 		if (e.state & SDL_BUTTON(SDL_BUTTON_LEFT) && resizingLevel)
@@ -186,7 +196,15 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 			if (mouse_y_window < canvas_ptr->height)
 				// canvas
 			{
-				if (holdingType != -1 && holdingID != -1)
+				if (holdingPrefab != -1)
+				{
+					stamping = true;
+					stampX = mouse_x;
+					stampY = mouse_y;
+					stamped.clear();
+					stampAt(mouse_x, mouse_y);
+				}
+				else if (holdingType != -1 && holdingID != -1)
 				{
 					editor_ptr->addObject(holdingID, holdingType, mouse_x - (mouse_x % 8), mouse_y - (mouse_y % 2));
 
@@ -252,6 +270,7 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 			{
 				holdingType = -1;
 				holdingID = -1;
+				holdingPrefab = -1;
 				if (mouse_y_window > g_window.height - BAR_HEIGHT + 3 && mouse_y_window < g_window.height - BAR_HEIGHT + 35)
 					//first row of buttons
 				{
@@ -269,7 +288,7 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 					}
 					if (mouse_x_window > 111 && mouse_x_window < 143)
 					{
-						level_ptr->save(true);
+						editor_ptr->save(true);
 					}
 				}
 				if (mouse_y_window > g_window.height - BAR_HEIGHT + 39 && mouse_y_window < g_window.height - BAR_HEIGHT + 71)
@@ -320,7 +339,7 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 					}
 					if (mouse_x_window > 39 && mouse_x_window < 71)
 					{
-						editor_ptr->paste();
+						editor_ptr->paste(false);
 					}
 					if (mouse_x_window > 75 && mouse_x_window < 107)
 					{
@@ -335,7 +354,16 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 			else if (mouse_y_window < g_window.height - 16)
 				// piece browser
 			{
-				if (holdingType == -1 && holdingID == -1)
+				if (bar_ptr->type == Bar::PREFABS)
+				{
+					int prefabSelected = bar_ptr->getPieceIDByScreenPos(mouse_x_window);
+					holdingPrefab = prefabSelected == holdingPrefab ? -1 : prefabSelected;
+					holdingType = -1;
+					holdingID = -1;
+					if (holdingPrefab != -1)
+						editor_ptr->select_none();
+				}
+				else if (holdingType == -1 && holdingID == -1)
 				{
 					int pieceSelected = bar_ptr->getPieceIDByScreenPos(mouse_x_window);
 					if (pieceSelected != -1)
@@ -396,17 +424,23 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 			scrollBarHolding = false;
 			scrollBarShifting = false;
 			movingCamera = false;
+			if (stamping)
+			{
+				stamping = false;
+				stamped.clear();
+			}
 			if (dragging)
 			{
 				if (startDragTime >= editor_ptr->gameFrameCount - 5) //single-clicked instead of dragging
 				{
 					editor_ptr->selection.clear();
-					Level::Object::Index temp = level_ptr->get_object_by_position(mouse_x, mouse_y);
+					Level::Object::Index temp = editor_ptr->grid.pick(mouse_x, mouse_y, canvas_ptr->layerVisible);
 					if (temp.i != -1)
 						editor_ptr->selection.insert(temp);
 				}
 				dragging = false;
 				startDragTime = 0;
+				editor_ptr->history.seal();
 			}
 			if (resizingLevel)
 			{
@@ -414,24 +448,24 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 				{
 				case (top):
 				{
-					level_ptr->resizeLevel(0, -resizingNewPos, true);
+					editor_ptr->resizeLevel(0, -resizingNewPos, true);
 					canvas_ptr->scroll(0, -resizingNewPos * canvas_ptr->zoom, false);
 					break;
 				}
 				case (bottom):
 				{
-					level_ptr->resizeLevel(0, resizingNewPos - level_ptr->height, false);
+					editor_ptr->resizeLevel(0, resizingNewPos - level_ptr->height, false);
 					break;
 				}
 				case (left):
 				{
-					level_ptr->resizeLevel(-resizingNewPos, 0, true);
+					editor_ptr->resizeLevel(-resizingNewPos, 0, true);
 					canvas_ptr->scroll(-resizingNewPos * canvas_ptr->zoom, 0, false);
 					break;
 				}
 				case (right):
 				{
-					level_ptr->resizeLevel(resizingNewPos - level_ptr->width, 0, false);
+					editor_ptr->resizeLevel(resizingNewPos - level_ptr->width, 0, false);
 					break;
 				}
 				}
@@ -502,10 +536,19 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 			else
 				bar_ptr->changeType(TOOL);
 			break;
+		case SDLK_4:
+		case SDLK_KP_4:
+			bar_ptr->changeType(Bar::PREFABS);
+			break;
+		case SDLK_b:
+			if (ctrl_down)
+				editor_ptr->saveSelectionAsPrefab();
+			break;
 		case SDLK_s:
-			level_ptr->save(true);
+			editor_ptr->save(true);
 			break;
 		case SDLK_ESCAPE:
+			holdingPrefab = -1;
 			editor_ptr->select_none();
 			break;
 		case SDLK_a:
@@ -519,9 +562,22 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 		case SDLK_p:
 			editor_ptr->levelProperties.openDialog();
 			break;
+		case SDLK_z:
+			if (ctrl_down)
+			{
+				if (e.keysym.mod & KMOD_SHIFT)
+					editor_ptr->redo();
+				else
+					editor_ptr->undo();
+			}
+			break;
+		case SDLK_y:
+			if (ctrl_down)
+				editor_ptr->redo();
+			break;
 		case SDLK_v:
 			if (ctrl_down) {
-				editor_ptr->paste();
+				editor_ptr->paste(mouse_y_window < canvas_ptr->height);
 			}
 			break;
 		case SDLK_UP:
@@ -576,13 +632,18 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 
 			canvas_ptr->scroll(delta_x, delta_y, dragging);
 		}
-		{ // bar scroll
+		if (!(SDL_GetModState() & KMOD_CTRL))
+		{ // bar scroll, but not while z is held for undo
 			const signed int left = key_state[SDL_GetScancodeFromKey(SDLK_z)] ? 20 : 0;
 			const signed int right = key_state[SDL_GetScancodeFromKey(SDLK_x)] ? 20 : 0;
 			signed int delta_x = (-left + right) * delta_multiplier;
 
 			bar_ptr->scroll(delta_x);
 		}
+		editor_ptr->autosave.tick(*level_ptr);
+		// not in the middle of dragging anything, so the objects can be swapped out
+		if (!(mouse_state & (SDL_BUTTON(SDL_BUTTON_LEFT) | SDL_BUTTON(SDL_BUTTON_RIGHT))))
+			editor_ptr->checkFilesChanged();
 		if (mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT))
 		{
 			if (mouse_y_window > g_window.height - 16) // scroll bar area
@@ -646,6 +707,8 @@ void Editor_input::handleEditorEvents(SDL_Event event)
 
 		if (holdingType != -1 && holdingID != -1)
 			canvas_ptr->drawHeldObject(holdingType, holdingID, mouse_x_window, mouse_y_window);
+		if (holdingPrefab != -1)
+			canvas_ptr->drawHeldPrefab(holdingPrefab, mouse_x_window, mouse_y_window);
 
 		SDL_RenderPresent(g_window.screen_renderer);
 
@@ -665,4 +728,28 @@ void Editor_input::startSelectionBox(void)
 	creatingSelectionBox = true;
 	creatingSelectionBoxStartX = creatingSelectionBoxCurrentX = mouse_x;
 	creatingSelectionBoxStartY = creatingSelectionBoxCurrentY = mouse_y;
+	editor_ptr->preview_area(creatingSelectionBoxStartX, creatingSelectionBoxStartY, 0, 0);
+}
+
+// Rounds towards negative infinity
+static int floorDiv(int value, int divisor)
+{
+	return value >= 0 ? value / divisor : -((-value - 1) / divisor) - 1;
+}
+
+// Stamps the held prefab in the grid square under x, y, unless this drag already has.
+// The squares are the size of the prefab, starting where the drag began.
+void Editor_input::stampAt(int x, int y)
+{
+	if (holdingPrefab < 0 || holdingPrefab >= (int)editor_ptr->prefabs.size())
+		return;
+
+	const PrefabLibrary::Prefab &prefab = editor_ptr->prefabs.prefabs[holdingPrefab];
+	int strideX = (prefab.width + 7) / 8 * 8;
+	int strideY = (prefab.height + 1) / 2 * 2;
+	std::pair<int, int> square(floorDiv(x - stampX, strideX), floorDiv(y - stampY, strideY));
+	if (!stamped.insert(square).second)
+		return;
+
+	editor_ptr->stampPrefab(holdingPrefab, stampX + square.first * strideX, stampY + square.second * strideY);
 }
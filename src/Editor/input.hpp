@@ -24,6 +24,9 @@
 #include "SDL.h"
 #include "SDL_ttf.h"
 
+#include <set>
+#include <utility>
+
 class Editor;
 class Bar;
 class Canvas;
@@ -53,6 +56,12 @@ public:
 	int scrollBarHoldingOffset;
 
 	int holdingID, holdingType;
+	int holdingPrefab;
+
+	// Dragging with a prefab stamps it once in each grid square the mouse passes over
+	bool stamping;
+	int stampX, stampY;
+	std::set< std::pair<int, int> > stamped;
 
 	bool movingView;
 
@@ -73,6 +82,7 @@ public:
 	void handleEditorEvents(SDL_Event event);
 
 	void startSelectionBox(void);
+	void stampAt(int x, int y);
 
 	Editor_input(void) { /* nothing to do */ }
 };
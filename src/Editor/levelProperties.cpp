@@ -48,40 +48,14 @@ void LevelProperties::setReferences(Editor * e, Bar * b, Canvas * c, Level * l)
 
 void LevelProperties::setup(void)
 {
-	TTF_Font * bigFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 30);
-	TTF_Font * smallFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 20);
-	titleText = Font::createTextureFromString(bigFont, "LEVEL PROPERTIES");
-	releaseRateText = Font::createTextureFromString(smallFont, "Release Rate:");
-	spawnDelayText = Font::createTextureFromString(smallFont, "Spawn Delay:");
-	timeLimitText = Font::createTextureFromString(smallFont, "Time Limit:");
-	timeLimitMinsText = Font::createTextureFromString(smallFont, "m");
-	timeLimitSecsText = Font::createTextureFromString(smallFont, "s");
-	OKButtonText = Font::createTextureFromString(smallFont, "OK");
-	cancelButtonText = Font::createTextureFromString(smallFont, "Cancel");
-	for (int i = 0; i < 10; i++)
-	{
-		char digit[2] = "0";
-		digit[0] += i;
-		numbers[i] = Font::createTextureFromString(smallFont, digit);
-	}
-	TTF_CloseFont(bigFont);
-	TTF_CloseFont(smallFont);
-}
-
-void LevelProperties::destroyTextures(void)
-{
-	if (titleText != NULL) SDL_DestroyTexture(titleText);
-	if (releaseRateText != NULL) SDL_DestroyTexture(releaseRateText);
-	if (spawnDelayText != NULL) SDL_DestroyTexture(spawnDelayText);
-	if (timeLimitText != NULL) SDL_DestroyTexture(timeLimitText);
-	if (timeLimitMinsText != NULL) SDL_DestroyTexture(timeLimitMinsText);
-	if (timeLimitSecsText != NULL) SDL_DestroyTexture(timeLimitSecsText);
-	if (OKButtonText != NULL) SDL_DestroyTexture(OKButtonText);
-	if (cancelButtonText != NULL) SDL_DestroyTexture(cancelButtonText);
-	for (int i = 0; i < 10; i++)
-	{
-		if (numbers[i] != NULL) SDL_DestroyTexture(numbers[i]);
-	}
+	titleText = Font::Label(30, "LEVEL PROPERTIES");
+	releaseRateText = Font::Label(20, "Release Rate:");
+	spawnDelayText = Font::Label(20, "Spawn Delay:");
+	timeLimitText = Font::Label(20, "Time Limit:");
+	timeLimitMinsText = Font::Label(20, "m");
+	timeLimitSecsText = Font::Label(20, "s");
+	OKButtonText = Font::Label(20, "OK");
+	cancelButtonText = Font::Label(20, "Cancel");
 }
 
 void LevelProperties::resize(void)
@@ -517,7 +491,7 @@ void LevelProperties::draw(void)
 			SDL_RenderFillRect(g_window.screen_renderer, &r);
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 			SDL_RenderDrawRect(g_window.screen_renderer, &r);
-			SDL_QueryTexture(OKButtonText, NULL, NULL, &textW, NULL);
+			textW = Font::stringWidth(OKButtonText.size, OKButtonText.text);
 			renderText(OKButtonText, dialogX + 83 - (textW / 2), dialogY + 132);
 
 			//Cancel
@@ -529,7 +503,7 @@ void LevelProperties::draw(void)
 			SDL_RenderFillRect(g_window.screen_renderer, &r);
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 			SDL_RenderDrawRect(g_window.screen_renderer, &r);
-			SDL_QueryTexture(cancelButtonText, NULL, NULL, &textW, NULL);
+			textW = Font::stringWidth(cancelButtonText.size, cancelButtonText.text);
 			renderText(cancelButtonText, dialogX + 216 - (textW / 2), dialogY + 132);
 		}
 
@@ -543,50 +517,12 @@ void LevelProperties::draw(void)
 	}
 }
 
-void LevelProperties::renderText(SDL_Texture * tex, int x, int y)
+void LevelProperties::renderText(const Font::Label &l, int x, int y)
 {
-	int textW, textH;
-	SDL_Rect textRect;
-
-	SDL_QueryTexture(tex, NULL, NULL, &textW, &textH);
-	textRect.x = x;
-	textRect.y = y;
-	textRect.w = textW;
-	textRect.h = textH;
-	SDL_RenderCopy(g_window.screen_renderer, tex, NULL, &textRect);
+	Font::drawString(l, x, y, Font::LEFT);
 }
 
 void LevelProperties::renderNumbers(int num, const int rightX, const int y)
 {
-	int numChars[3];
-	int size = 0;
-	if (num == 0)
-	{
-		size = 1;
-		numChars[0] = 0;
-	}
-	else
-	{
-		while (num != 0)
-		{
-			//load number characters into array in reverse order
-			numChars[size] = num % 10;
-			num /= 10;
-			size++;
-		}
-	}
-
-	int textW, textH, drawX;
-	SDL_Rect textRect;
-	drawX = rightX;
-	for (int i = 0; i < size; i++)
-	{
-		SDL_QueryTexture(numbers[numChars[i]], NULL, NULL, &textW, &textH);
-		drawX -= textW;
-		textRect.x = drawX;
-		textRect.y = y;
-		textRect.w = textW;
-		textRect.h = textH;
-		SDL_RenderCopy(g_window.screen_renderer, numbers[numChars[i]], NULL, &textRect);
-	}
+	Font::drawString(20, std::to_string(num), rightX, y, Font::RIGHT);
 }
@@ -21,6 +21,8 @@
 #ifndef LEVELPROPERTIES_HPP
 #define LEVELPROPERTIES_HPP
 
+#include "../font.hpp"
+
 #include "SDL.h"
 #include "SDL_ttf.h"
 
@@ -46,15 +48,14 @@ public:
 	bool redraw;
 	int dialogX, dialogY;
 
-	SDL_Texture * titleText = NULL;
-	SDL_Texture * releaseRateText = NULL;
-	SDL_Texture * spawnDelayText = NULL;
-	SDL_Texture * timeLimitText = NULL;
-	SDL_Texture * timeLimitMinsText = NULL;
-	SDL_Texture * timeLimitSecsText = NULL;
-	SDL_Texture * OKButtonText = NULL;
-	SDL_Texture * cancelButtonText = NULL;
-	SDL_Texture * numbers[10] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	Font::Label titleText;
+	Font::Label releaseRateText;
+	Font::Label spawnDelayText;
+	Font::Label timeLimitText;
+	Font::Label timeLimitMinsText;
+	Font::Label timeLimitSecsText;
+	Font::Label OKButtonText;
+	Font::Label cancelButtonText;
 
 	enum inputBox { NONE, RELEASERATE, SPAWNDELAY, TIMELIMITMINS, TIMELIMITSECS };
 
@@ -62,7 +63,6 @@ public:
 
 	void setReferences(Editor * e, Bar * b, Canvas * c, Level * l);
 	void setup(void);
-	void destroyTextures(void);
 	void resize(void);
 
 	void openDialog(void);
@@ -73,7 +73,7 @@ public:
 	void typedNumber(inputBox input, const unsigned int value);
 
 	void draw(void);
-	void renderText(SDL_Texture * tex, int x, int y);
+	void renderText(const Font::Label &l, int x, int y);
 	void renderNumbers(int num, const int rightX, const int y);
 
 	LevelProperties(void) { /* nothing to do */ }
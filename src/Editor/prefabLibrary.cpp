@@ -0,0 +1,174 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for saving, loading and drawing prefabs
+*/
+
+#include "prefabLibrary.hpp"
+#include "../lem3edit.hpp"
+#include "../style.hpp"
+#include "../window.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+void PrefabLibrary::load(const fs::path levelPath, const Style &style, Uint16 styleNumber)
+{
+	destroy();
+	folder = folderFor(levelPath);
+
+	error_code ec;
+	if (!fs::is_directory(folder, ec))
+		return;
+
+	vector<fs::path> files;
+	for (fs::directory_iterator i(folder, ec), end; !ec && i != end; i.increment(ec))
+	{
+		if (i->path().extension() == ".l3prefab")
+			files.push_back(i->path());
+	}
+	sort(files.begin(), files.end());
+
+	for (vector<fs::path>::const_iterator i = files.begin(); i != files.end(); ++i)
+	{
+		Prefab prefab;
+		prefab.file = *i;
+		if (!prefab.objects.load(*i) || !render(prefab, style, styleNumber))
+			continue;
+		prefabs.push_back(prefab);
+	}
+	SDL_Log("Loaded %d prefabs from '%s'\n", prefabs.size(), folder.generic_string().c_str());
+}
+
+bool PrefabLibrary::add(const Clipboard &objects, const Style &style, Uint16 styleNumber)
+{
+	if (objects.empty())
+		return false;
+
+	error_code ec;
+	fs::create_directories(folder, ec);
+
+	// Take the first unused number, so prefabs list in the order they were made
+	Prefab prefab;
+	for (int n = 1; ; ++n)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "prefab%03d.l3prefab", n);
+		prefab.file = folder / name;
+		if (!fs::exists(prefab.file, ec))
+			break;
+	}
+
+	prefab.objects = objects;
+	if (!prefab.objects.save(prefab.file) || !render(prefab, style, styleNumber))
+		return false;
+
+	prefabs.push_back(prefab);
+	return true;
+}
+
+void PrefabLibrary::destroy(void)
+{
+	for (vector<Prefab>::iterator i = prefabs.begin(); i != prefabs.end(); ++i)
+	{
+		if (i->texture != NULL)
+			SDL_DestroyTexture(i->texture);
+	}
+	prefabs.clear();
+}
+
+bool PrefabLibrary::render(Prefab &prefab, const Style &style, Uint16 styleNumber)
+{
+	// The pieces standing in for the stored ones decide how big the prefab is
+	prefab.width = prefab.height = 0;
+	for (vector<Clipboard::Item>::const_iterator i = prefab.objects.items.begin(); i != prefab.objects.items.end(); ++i)
+	{
+		int so = style.object_by_id(i->type, prefab.objects.idInStyle(style, styleNumber, *i));
+		if (so == -1)
+			continue;
+		prefab.width = max(prefab.width, i->x + style.object[i->type][so].width * 8);
+		prefab.height = max(prefab.height, i->y + style.object[i->type][so].height * 2);
+	}
+	if (prefab.width <= 0 || prefab.height <= 0)
+	{
+		SDL_Log("Prefab '%s' has nothing to draw in this style\n", prefab.file.generic_string().c_str());
+		return false;
+	}
+
+	prefab.texture = SDL_CreateTexture(g_window.screen_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, prefab.width, prefab.height);
+	if (prefab.texture == NULL)
+	{
+		SDL_Log("Unable to create prefab texture! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+	SDL_SetTextureBlendMode(prefab.texture, SDL_BLENDMODE_BLEND);
+
+	SDL_Texture *previousTarget = SDL_GetRenderTarget(g_window.screen_renderer);
+	SDL_SetRenderTarget(g_window.screen_renderer, prefab.texture);
+	SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 0);
+	SDL_RenderClear(g_window.screen_renderer);
+
+	// Items are stored layer by layer in drawing order, so they overlap as they did in the level
+	for (vector<Clipboard::Item>::const_iterator i = prefab.objects.items.begin(); i != prefab.objects.items.end(); ++i)
+	{
+		int so = style.object_by_id(i->type, prefab.objects.idInStyle(style, styleNumber, *i));
+		if (so == -1)
+			continue;
+
+		SDL_Rect dest;
+		dest.x = i->x;
+		dest.y = i->y;
+		dest.w = style.object[i->type][so].width * 8;
+		dest.h = style.object[i->type][so].height * 2;
+		SDL_RenderCopy(g_window.screen_renderer, style.object[i->type][so].objTex, NULL, &dest);
+	}
+
+	SDL_SetRenderTarget(g_window.screen_renderer, previousTarget);
+	return true;
+}
+
+void PrefabLibrary::draw(unsigned int n, signed int x, signed int y, int zoom, int maxSize) const
+{
+	if (n >= prefabs.size())
+		return;
+
+	SDL_Rect rdest;
+	rdest.x = x;
+	rdest.y = y;
+	rdest.w = prefabs[n].width * zoom;
+	rdest.h = prefabs[n].height * zoom;
+	if (maxSize != 0 && max(rdest.w, rdest.h) > maxSize)
+	{
+		int factor = (max(rdest.w, rdest.h) * 100) / maxSize;
+		rdest.w = (rdest.w * 100) / factor;
+		rdest.h = (rdest.h * 100) / factor;
+	}
+
+	SDL_RenderCopy(g_window.screen_renderer, prefabs[n].texture, NULL, &rdest);
+}
@@ -0,0 +1,69 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef PREFABLIBRARY_HPP
+#define PREFABLIBRARY_HPP
+
+#include "clipboard.hpp"
+
+#include "SDL.h"
+
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Style;
+
+// Groups of objects saved for placing again and again, kept as .l3prefab files in a
+// PREFABS folder next to the level. Each prefab is drawn once into its own texture when
+// the library is loaded, so showing it in the bar or under the cursor is a single copy.
+class PrefabLibrary
+{
+public:
+	class Prefab
+	{
+	public:
+		fs::path file;
+		Clipboard objects;
+		SDL_Texture * texture = NULL;
+		int width = 0, height = 0; // in pixels
+	};
+
+	std::vector<Prefab> prefabs;
+
+	size_t size(void) const { return prefabs.size(); }
+
+	void load(const fs::path levelPath, const Style &style, Uint16 styleNumber);
+	bool add(const Clipboard &objects, const Style &style, Uint16 styleNumber);
+	void destroy(void);
+
+	// Draws a prefab scaled to fit inside maxSize, pass 0 for maxSize to allow any size
+	void draw(unsigned int n, signed int x, signed int y, int zoom, int maxSize) const;
+
+	static fs::path folderFor(const fs::path levelPath) { return levelPath.parent_path() / "PREFABS"; }
+
+private:
+	fs::path folder;
+
+	bool render(Prefab &prefab, const Style &style, Uint16 styleNumber);
+};
+
+#endif // PREFABLIBRARY_HPP
@@ -0,0 +1,235 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for storing which objects are selected in the editor
+*/
+
+#include "selection.hpp"
+#include "../level.hpp"
+#include "../style.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+#define BITS_PER_WORD 64
+
+// Position of the lowest set bit of a non-zero word
+static inline int lowestBit(Uint64 word)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long bit;
+	_BitScanForward64(&bit, word);
+	return bit;
+#else
+	int bit = 0;
+	while (!(word & 1))
+	{
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+Selection::const_iterator::const_iterator(const Selection *selection, int type, Uint32 slot) : selection(selection), type(type), slot(slot), current(type, -1)
+{
+	findFrom(type, slot);
+}
+
+Selection::const_iterator & Selection::const_iterator::operator++()
+{
+	findFrom(type, slot + 1);
+	return *this;
+}
+
+// Moves to the first selected object still in the level at or after the slot, or to end()
+void Selection::const_iterator::findFrom(int t, Uint32 s)
+{
+	for (; t < 3; ++t, s = 0)
+	{
+		const vector<Uint64> &words = selection->bits[t];
+		size_t w = s / BITS_PER_WORD;
+		if (w >= words.size())
+			continue;
+
+		Uint64 word = words[w] & (~(Uint64)0 << (s % BITS_PER_WORD));
+		while (true)
+		{
+			while (word != 0)
+			{
+				Uint32 found = w * BITS_PER_WORD + lowestBit(word);
+				int position = selection->level->object[t].positionOf(found, selection->generation[t][found]);
+				if (position != -1)
+				{
+					type = t;
+					slot = found;
+					current = Level::Object::Index(t, position);
+					return;
+				}
+				word &= word - 1;
+			}
+			if (++w >= words.size())
+				break;
+			word = words[w];
+		}
+	}
+	type = 3;
+	slot = 0;
+	current = Level::Object::Index(3, -1);
+}
+
+Selection::Selection(void) : level(NULL), count(0), boundsValid(false)
+{
+	boundsCache.x = boundsCache.y = boundsCache.w = boundsCache.h = 0;
+}
+
+void Selection::grow(int type, size_t slots)
+{
+	size_t words = (slots + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	if (bits[type].size() < words)
+	{
+		bits[type].resize(words, 0);
+		generation[type].resize(words * BITS_PER_WORD, 0);
+	}
+}
+
+bool Selection::isSet(int type, Uint32 slot) const
+{
+	size_t w = slot / BITS_PER_WORD;
+	return w < bits[type].size() && ((bits[type][w] >> (slot % BITS_PER_WORD)) & 1);
+}
+
+bool Selection::contains(const Level::Object::Index &index) const
+{
+	if (index.i < 0 || index.i >= (int)level->object[index.type].size())
+		return false;
+
+	Level::Object::Handle h = level->handle(index);
+	return isSet(h.type, h.slot) && generation[h.type][h.slot] == h.generation;
+}
+
+void Selection::insert(const Level::Object::Index &index)
+{
+	if (index.i < 0 || index.i >= (int)level->object[index.type].size())
+		return;
+
+	insert(level->handle(index));
+}
+
+void Selection::insert(const Level::Object::Handle &h)
+{
+	grow(h.type, h.slot + 1);
+	if (!isSet(h.type, h.slot))
+	{
+		bits[h.type][h.slot / BITS_PER_WORD] |= (Uint64)1 << (h.slot % BITS_PER_WORD);
+		count++;
+	}
+	else if (generation[h.type][h.slot] == h.generation)
+		return;
+
+	// A set bit with an old generation was an object since removed, so this replaces it
+	generation[h.type][h.slot] = h.generation;
+	boundsValid = false;
+}
+
+void Selection::erase(const Level::Object::Index &index)
+{
+	if (!contains(index))
+		return;
+
+	Level::Object::Handle h = level->handle(index);
+	bits[h.type][h.slot / BITS_PER_WORD] &= ~((Uint64)1 << (h.slot % BITS_PER_WORD));
+	count--;
+	boundsValid = false;
+}
+
+void Selection::clear(void)
+{
+	if (count != 0)
+	{
+		for (int type = 0; type < 3; ++type)
+			fill(bits[type].begin(), bits[type].end(), 0);
+	}
+	count = 0;
+	boundsValid = false;
+}
+
+void Selection::insertAll(int type, size_t n)
+{
+	grow(type, level->object[type].slotCount());
+	for (size_t i = 0; i < n; ++i)
+		insert(level->handle(Level::Object::Index(type, i)));
+}
+
+void Selection::sortedIndexes(vector<Level::Object::Index> &indexes) const
+{
+	indexes.assign(begin(), end());
+	sort(indexes.begin(), indexes.end());
+}
+
+SDL_Rect Selection::bounds(const Style &style) const
+{
+	if (boundsValid)
+		return boundsCache;
+
+	int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+	for (const_iterator i = begin(); i != end(); ++i)
+	{
+		const Level::Object &o = level->object[i->type][i->i];
+		int so = style.object_by_id(i->type, o.id);
+		int w = so == -1 ? 0 : style.object[i->type][so].width * 8;
+		int h = so == -1 ? 0 : style.object[i->type][so].height * 2;
+
+		left = min(left, level->objectX(o));
+		top = min(top, level->objectY(o));
+		right = max(right, level->objectX(o) + w);
+		bottom = max(bottom, level->objectY(o) + h);
+	}
+
+	if (left > right)
+		boundsCache.x = boundsCache.y = boundsCache.w = boundsCache.h = 0;
+	else
+	{
+		boundsCache.x = left;
+		boundsCache.y = top;
+		boundsCache.w = right - left;
+		boundsCache.h = bottom - top;
+	}
+	boundsValid = true;
+	return boundsCache;
+}
+
+void Selection::offsetBounds(int delta_x, int delta_y)
+{
+	boundsCache.x += delta_x;
+	boundsCache.y += delta_y;
+}
@@ -0,0 +1,119 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+#include "../level.hpp"
+
+#include "SDL.h"
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+class Style;
+
+// The selected objects, kept as one bit per object slot in each layer. Slots belong to
+// objects rather than positions, so reordering a layer never changes what is selected,
+// and removed objects drop out by themselves. Once the bitsets have grown to the size
+// of the level, selecting and clearing never allocate.
+class Selection
+{
+public:
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Level::Object::Index value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const Level::Object::Index * pointer;
+		typedef const Level::Object::Index & reference;
+
+		const_iterator(const Selection *selection, int type, Uint32 slot);
+
+		reference operator*() const { return current; }
+		pointer operator->() const { return &current; }
+		const_iterator & operator++();
+		const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+
+		bool operator==(const const_iterator &that) const { return type == that.type && slot == that.slot; }
+		bool operator!=(const const_iterator &that) const { return !(*this == that); }
+
+	private:
+		const Selection *selection;
+		int type;
+		Uint32 slot;
+		Level::Object::Index current;
+
+		void findFrom(int type, Uint32 slot);
+	};
+
+	// Gives the current positions of the selected objects, in layer then slot order
+	const_iterator begin(void) const { return const_iterator(this, 0, 0); }
+	const_iterator end(void) const { return const_iterator(this, 3, 0); }
+	// The same but in layer then position order, for anything that needs to walk a layer in order
+	void sortedIndexes(std::vector<Level::Object::Index> &indexes) const;
+
+	bool empty(void) const { return count == 0; }
+	size_t size(void) const { return count; }
+
+	bool contains(const Level::Object::Index &index) const;
+	void insert(const Level::Object::Index &index);
+	void insert(const Level::Object::Handle &handle);
+	void erase(const Level::Object::Index &index);
+	void clear(void);
+
+	template <class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	// Selects objects 0 to n - 1 of a layer
+	void insertAll(int type, size_t n);
+
+	// The area covered by every selected object, worked out once then kept until the selection changes
+	SDL_Rect bounds(const Style &style) const;
+	// Keeps the cached bounds right when the selected objects are moved
+	void offsetBounds(int delta_x, int delta_y);
+	// For when objects move without the selection changing, like a resize that shifts the level
+	void invalidateBounds(void) { boundsValid = false; }
+
+	void setLevel(const Level *l) { level = l; }
+
+	Selection(void);
+
+private:
+	const Level *level;
+
+	std::vector<Uint64> bits[3]; // by slot
+	std::vector<Uint32> generation[3]; // by slot, the generation of the object that was selected
+	size_t count;
+
+	mutable bool boundsValid;
+	mutable SDL_Rect boundsCache;
+
+	void grow(int type, size_t slots);
+	bool isSet(int type, Uint32 slot) const;
+};
+
+#endif // SELECTION_HPP
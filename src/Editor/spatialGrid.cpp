@@ -0,0 +1,232 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for finding which objects lie in part of the level without looking at all of them
+*/
+
+#include "spatialGrid.hpp"
+#include "../level.hpp"
+#include "../style.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+using namespace std;
+
+// Rounds towards negative infinity, so objects left of or above the level get their own cells
+static inline int cellOf(int pixel)
+{
+	return pixel >= 0 ? pixel / SpatialGrid::CELL_SIZE : -((-pixel - 1) / SpatialGrid::CELL_SIZE) - 1;
+}
+
+SpatialGrid::SpatialGrid(void) : level_ptr(NULL), style_ptr(NULL), valid(false), originX(0), originY(0), columns(0), rows(0), queryCount(0)
+{
+}
+
+void SpatialGrid::setReferences(const Level *l, const Style *s)
+{
+	level_ptr = l;
+	style_ptr = s;
+	valid = false;
+}
+
+bool SpatialGrid::update(void)
+{
+	if (valid)
+		return false;
+
+	int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+	for (int type = 0; type < 3; ++type)
+	{
+		const SlotMap<Level::Object> &objects = level_ptr->object[type];
+		box[type].assign(objects.slotCount(), SDL_Rect());
+		if (stamp[type].size() < objects.slotCount())
+			stamp[type].resize(objects.slotCount(), 0);
+
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			const Level::Object &o = objects[i];
+			SDL_Rect &b = box[type][objects.slotAt(i)];
+			b.x = level_ptr->objectX(o);
+			b.y = level_ptr->objectY(o);
+			b.w = b.h = 0;
+
+			int so = style_ptr->object_by_id(type, o.id);
+			if (so == -1)
+				continue;
+			b.w = style_ptr->object[type][so].width * 8;
+			b.h = style_ptr->object[type][so].height * 2;
+			if (b.w <= 0 || b.h <= 0)
+				continue;
+
+			left = min(left, cellOf(b.x));
+			top = min(top, cellOf(b.y));
+			right = max(right, cellOf(b.x + b.w - 1));
+			bottom = max(bottom, cellOf(b.y + b.h - 1));
+		}
+	}
+
+	if (left > right)
+	{
+		originX = originY = 0;
+		columns = rows = 0;
+	}
+	else
+	{
+		originX = left;
+		originY = top;
+		columns = right - left + 1;
+		rows = bottom - top + 1;
+	}
+
+	// Count the entries in each cell, turn the counts into offsets, then fill them in
+	cellStart.assign(columns * rows + 1, 0);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int type = 0; type < 3; ++type)
+		{
+			const SlotMap<Level::Object> &objects = level_ptr->object[type];
+			for (size_t i = 0; i < objects.size(); ++i)
+			{
+				Uint32 slot = objects.slotAt(i);
+				const SDL_Rect &b = box[type][slot];
+				if (b.w <= 0 || b.h <= 0)
+					continue;
+
+				int cellLeft, cellTop, cellRight, cellBottom;
+				cellRange(b, cellLeft, cellTop, cellRight, cellBottom);
+				for (int y = cellTop; y <= cellBottom; ++y)
+				{
+					for (int x = cellLeft; x <= cellRight; ++x)
+					{
+						if (pass == 0)
+							cellStart[y * columns + x + 1]++;
+						else
+							entries[cellStart[y * columns + x]++] = Entry(type, slot);
+					}
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (size_t c = 1; c < cellStart.size(); ++c)
+				cellStart[c] += cellStart[c - 1];
+			entries.assign(cellStart.back(), Entry(0, 0));
+		}
+	}
+	// Filling moved every offset along by one cell
+	for (size_t c = cellStart.size() - 1; c > 0; --c)
+		cellStart[c] = cellStart[c - 1];
+	cellStart[0] = 0;
+
+	valid = true;
+	return true;
+}
+
+void SpatialGrid::cellRange(const SDL_Rect &area, int &left, int &top, int &right, int &bottom) const
+{
+	left = max(cellOf(area.x) - originX, 0);
+	top = max(cellOf(area.y) - originY, 0);
+	right = min(cellOf(area.x + area.w - 1) - originX, columns - 1);
+	bottom = min(cellOf(area.y + area.h - 1) - originY, rows - 1);
+}
+
+void SpatialGrid::query(const SDL_Rect &area, const SDL_Rect *skip, const bool layers[3], vector<Level::Object::Index> &found)
+{
+	update();
+
+	if (area.w <= 0 || area.h <= 0)
+		return;
+
+	if (++queryCount == 0)
+	{
+		for (int type = 0; type < 3; ++type)
+			fill(stamp[type].begin(), stamp[type].end(), 0);
+		queryCount = 1;
+	}
+
+	int left, top, right, bottom;
+	cellRange(area, left, top, right, bottom);
+	for (int y = top; y <= bottom; ++y)
+	{
+		for (int x = left; x <= right; ++x)
+		{
+			if (skip != NULL)
+			{
+				int cellX = (x + originX) * CELL_SIZE;
+				int cellY = (y + originY) * CELL_SIZE;
+				if (cellX >= skip->x && cellX + CELL_SIZE <= skip->x + skip->w && cellY >= skip->y && cellY + CELL_SIZE <= skip->y + skip->h)
+					continue;
+			}
+
+			for (Uint32 e = cellStart[y * columns + x]; e < cellStart[y * columns + x + 1]; ++e)
+			{
+				const Entry &entry = entries[e];
+				if (!layers[entry.type] || stamp[entry.type][entry.slot] == queryCount)
+					continue;
+				stamp[entry.type][entry.slot] = queryCount;
+
+				const SlotMap<Level::Object> &objects = level_ptr->object[entry.type];
+				found.push_back(Level::Object::Index(entry.type, objects.positionOf(entry.slot, objects.generationOf(entry.slot))));
+			}
+		}
+	}
+}
+
+bool SpatialGrid::touches(const Level::Object::Index &index, const SDL_Rect &area) const
+{
+	const SDL_Rect &b = box[index.type][level_ptr->object[index.type].slotAt(index.i)];
+	if (b.w <= 0 || b.h <= 0)
+		return false;
+
+	return area.x < b.x + b.w && b.x < area.x + area.w && area.y < b.y + b.h && b.y < area.y + area.h;
+}
+
+Level::Object::Index SpatialGrid::pick(signed int x, signed int y, const bool layers[3])
+{
+	SDL_Rect point;
+	point.x = x;
+	point.y = y;
+	point.w = point.h = 1;
+
+	vector<Level::Object::Index> found;
+	query(point, NULL, layers, found);
+
+	// Later layers and later objects in a layer are drawn on top
+	Level::Object::Index best(0, -1);
+	for (vector<Level::Object::Index>::const_iterator i = found.begin(); i != found.end(); ++i)
+	{
+		if (best.i != -1 && *i < best)
+			continue;
+		if (!touches(*i, point))
+			continue;
+
+		const Level::Object &o = level_ptr->object[i->type][i->i];
+		int so = style_ptr->object_by_id(i->type, o.id);
+		if (so != -1 && style_ptr->object[i->type][so].opaque_at(x - level_ptr->objectX(o), y - level_ptr->objectY(o)))
+			best = *i;
+	}
+	return best;
+}
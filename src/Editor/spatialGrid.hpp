@@ -0,0 +1,88 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+
+#include "../level.hpp"
+
+#include "SDL.h"
+
+#include <vector>
+
+class Style;
+
+// A uniform grid over the level that lists which objects touch each cell, so area and
+// point queries only look at the objects near them instead of every object in the level.
+// It is built from scratch when first needed after the level changes, which costs one
+// pass over the objects; anything that moves, adds, removes or changes objects must call
+// invalidate(). Objects are kept by slot, so reordering a layer needs no rebuild.
+class SpatialGrid
+{
+public:
+	static const int CELL_SIZE = 64; // in pixels
+
+	void setReferences(const Level *l, const Style *s);
+
+	void invalidate(void) { valid = false; }
+	// Returns true if the grid had to be rebuilt
+	bool update(void);
+
+	// Finds the objects whose boxes may touch the area, each one once. Cells lying entirely
+	// inside skip are not looked at, so passing the part two areas share gives just the
+	// objects that can be in one but not the other.
+	void query(const SDL_Rect &area, const SDL_Rect *skip, const bool layers[3], std::vector<Level::Object::Index> &found);
+
+	// Whether the box of an object found by query touches the area
+	bool touches(const Level::Object::Index &index, const SDL_Rect &area) const;
+
+	// The frontmost object drawn at the pixel, ignoring see-through parts of objects. i is -1 if there is none.
+	Level::Object::Index pick(signed int x, signed int y, const bool layers[3]);
+
+	SpatialGrid(void);
+
+private:
+	class Entry
+	{
+	public:
+		int type;
+		Uint32 slot;
+
+		Entry(int type, Uint32 slot) : type(type), slot(slot) { }
+	};
+
+	const Level *level_ptr;
+	const Style *style_ptr;
+
+	bool valid;
+
+	int originX, originY; // the top left cell, in cells
+	int columns, rows;
+	std::vector<Uint32> cellStart; // where each cell's entries begin, one extra on the end
+	std::vector<Entry> entries;
+
+	std::vector<SDL_Rect> box[3]; // by slot
+	std::vector<Uint32> stamp[3]; // by slot, the query that last found the object
+	Uint32 queryCount;
+
+	void cellRange(const SDL_Rect &area, int &left, int &top, int &right, int &bottom) const;
+};
+
+#endif // SPATIALGRID_HPP
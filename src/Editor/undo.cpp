@@ -0,0 +1,304 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+This file includes code for the editor's undo and redo history
+*/
+
+#include "undo.hpp"
+#include "../lem3edit.hpp"
+#include "../level.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#define DEFAULT_UNDO_MEMORY (4 * 1024 * 1024)
+
+size_t Undo::Entry::memoryUsed(void) const
+{
+	return sizeof(Entry)
+		+ indexes.capacity() * sizeof(Level::Object::Index)
+		+ objects.capacity() * sizeof(Level::Object)
+		+ (oldIds.capacity() + newIds.capacity()) * sizeof(Uint16);
+}
+
+Undo::Undo(void) : memoryUsed(0), memoryBudget(DEFAULT_UNDO_MEMORY), mergeOpen(false)
+{
+	/* nothing to do */
+}
+
+void Undo::clear(void)
+{
+	done.clear();
+	undone.clear();
+	memoryUsed = 0;
+	mergeOpen = false;
+}
+
+void Undo::setMemoryBudget(size_t bytes)
+{
+	memoryBudget = bytes;
+	trim();
+}
+
+void Undo::seal(void)
+{
+	mergeOpen = false;
+}
+
+void Undo::push(const Entry &entry)
+{
+	// A new action means the undone ones can't be redone any more
+	for (vector<Entry>::const_iterator i = undone.begin(); i != undone.end(); ++i)
+		memoryUsed -= i->memoryUsed();
+	undone.clear();
+
+	done.push_back(entry);
+	memoryUsed += done.back().memoryUsed();
+	mergeOpen = false;
+	trim();
+}
+
+// Forget the oldest actions until the history fits the budget, always keeping the latest one
+void Undo::trim(void)
+{
+	while (memoryUsed > memoryBudget && done.size() > 1)
+	{
+		memoryUsed -= done.front().memoryUsed();
+		done.pop_front();
+	}
+}
+
+void Undo::recordMove(const Selection &selection, int delta_x, int delta_y, bool merge)
+{
+	if (selection.empty() || (delta_x == 0 && delta_y == 0))
+		return;
+
+	// Every step of a drag goes into the same entry, without allocating anything
+	if (merge && mergeOpen && !done.empty())
+	{
+		Entry &last = done.back();
+		if (last.action == MOVE && last.indexes.size() == selection.size() && equal(selection.begin(), selection.end(), last.indexes.begin(),
+			[](const Level::Object::Index &a, const Level::Object::Index &b) { return a.type == b.type && a.i == b.i; }))
+		{
+			last.delta_x += delta_x;
+			last.delta_y += delta_y;
+			return;
+		}
+	}
+
+	Entry entry(MOVE);
+	entry.indexes.assign(selection.begin(), selection.end());
+	entry.delta_x = delta_x;
+	entry.delta_y = delta_y;
+	push(entry);
+	mergeOpen = merge;
+}
+
+void Undo::recordIdChange(const vector<Level::Object::Index> &indexes, const vector<Uint16> &oldIds, const vector<Uint16> &newIds)
+{
+	if (indexes.empty() || oldIds == newIds)
+		return;
+
+	Entry entry(CHANGE_ID);
+	entry.indexes = indexes;
+	entry.oldIds = oldIds;
+	entry.newIds = newIds;
+	push(entry);
+}
+
+void Undo::recordAdd(const vector<Level::Object::Index> &indexes, const vector<Level::Object> &objects)
+{
+	if (indexes.empty())
+		return;
+
+	Entry entry(ADD);
+	entry.indexes = indexes;
+	entry.objects = objects;
+	push(entry);
+}
+
+void Undo::recordDelete(const vector<Level::Object::Index> &indexes, const vector<Level::Object> &objects)
+{
+	if (indexes.empty())
+		return;
+
+	Entry entry(DELETE);
+	entry.indexes = indexes;
+	entry.objects = objects;
+	push(entry);
+}
+
+void Undo::recordReorder(const vector<Level::Object::Index> &indexes, bool toFront)
+{
+	if (indexes.empty())
+		return;
+
+	Entry entry(toFront ? MOVE_TO_FRONT : MOVE_TO_BACK);
+	entry.indexes = indexes;
+	push(entry);
+}
+
+void Undo::recordResize(int delta_x, int delta_y, bool shiftLevel, Sint16 oldCameraX, Sint16 oldCameraY)
+{
+	if (delta_x == 0 && delta_y == 0)
+		return;
+
+	Entry entry(RESIZE);
+	entry.delta_x = delta_x;
+	entry.delta_y = delta_y;
+	entry.shiftLevel = shiftLevel;
+	entry.oldCameraX = oldCameraX;
+	entry.oldCameraY = oldCameraY;
+	push(entry);
+}
+
+bool Undo::undo(Level &level, vector<Level::Object::Index> &affected)
+{
+	affected.clear();
+	mergeOpen = false;
+	if (done.empty())
+		return false;
+
+	apply(level, done.back(), false, affected);
+	undone.push_back(done.back());
+	done.pop_back();
+	return true;
+}
+
+bool Undo::redo(Level &level, vector<Level::Object::Index> &affected)
+{
+	affected.clear();
+	mergeOpen = false;
+	if (undone.empty())
+		return false;
+
+	apply(level, undone.back(), true, affected);
+	done.push_back(undone.back());
+	undone.pop_back();
+	return true;
+}
+
+void Undo::apply(Level &level, const Entry &entry, bool forwards, vector<Level::Object::Index> &affected)
+{
+	// Split the indexes and objects by layer
+	vector<int> positions[3];
+	vector<Level::Object> objects[3];
+	for (size_t i = 0; i < entry.indexes.size(); ++i)
+	{
+		positions[entry.indexes[i].type].push_back(entry.indexes[i].i);
+		if (i < entry.objects.size())
+		{
+			// Stored at their real positions, as the origin may have been folded in since
+			Level::Object o = entry.objects[i];
+			level.placeObject(o, o.x, o.y);
+			objects[entry.indexes[i].type].push_back(o);
+		}
+	}
+
+	switch (entry.action)
+	{
+	case MOVE:
+	{
+		int sign = forwards ? 1 : -1;
+		for (vector<Level::Object::Index>::const_iterator i = entry.indexes.begin(); i != entry.indexes.end(); ++i)
+		{
+			Level::Object &o = level.object[i->type][i->i];
+			o.x += entry.delta_x * sign;
+			o.y += entry.delta_y * sign;
+		}
+		affected = entry.indexes;
+		break;
+	}
+	case CHANGE_ID:
+	{
+		const vector<Uint16> &ids = forwards ? entry.newIds : entry.oldIds;
+		for (size_t i = 0; i < entry.indexes.size(); ++i)
+			level.object[entry.indexes[i].type][entry.indexes[i].i].id = ids[i];
+		affected = entry.indexes;
+		break;
+	}
+	case ADD:
+		if (forwards)
+		{
+			for (size_t i = 0; i < entry.indexes.size(); ++i)
+			{
+				Level::Object o = entry.objects[i];
+				level.placeObject(o, o.x, o.y);
+				level.object[entry.indexes[i].type].push_back(o);
+			}
+			affected = entry.indexes;
+		}
+		else
+		{
+			for (size_t i = entry.indexes.size(); i-- > 0;)
+				level.object[entry.indexes[i].type].pop_back();
+		}
+		break;
+	case DELETE:
+		for (int type = 0; type < 3; ++type)
+		{
+			if (forwards)
+				level.object[type].removeAt(positions[type], NULL);
+			else
+				level.object[type].insertAt(positions[type], objects[type]);
+		}
+		if (!forwards)
+			affected = entry.indexes;
+		break;
+	case MOVE_TO_FRONT:
+	case MOVE_TO_BACK:
+	{
+		bool toFront = entry.action == MOVE_TO_FRONT;
+		for (int type = 0; type < 3; ++type)
+		{
+			const int count = positions[type].size();
+			if (count == 0)
+				continue;
+
+			if (forwards)
+			{
+				level.reorder_objects(type, positions[type], toFront);
+				int first = toFront ? level.object[type].size() - count : 0;
+				for (int i = 0; i < count; ++i)
+					affected.push_back(Level::Object::Index(type, first + i));
+			}
+			else
+				level.object[type].moveBack(positions[type], toFront);
+		}
+		if (!forwards)
+			affected = entry.indexes;
+		break;
+	}
+	case RESIZE:
+		if (forwards)
+			level.resizeLevel(entry.delta_x, entry.delta_y, entry.shiftLevel);
+		else
+		{
+			level.resizeLevel(-entry.delta_x, -entry.delta_y, entry.shiftLevel);
+			level.cameraX = entry.oldCameraX;
+			level.cameraY = entry.oldCameraY;
+		}
+		break;
+	}
+}
@@ -0,0 +1,96 @@
+/*
+* lem3edit
+* Copyright (C) 2008-2009 Carl Reinke
+* Copyright (C) 2017-2018 Kieran Millar
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef UNDO_HPP
+#define UNDO_HPP
+
+#include "selection.hpp"
+#include "../level.hpp"
+
+#include "SDL.h"
+
+#include <deque>
+#include <vector>
+
+// Undo and redo history for the editor. Each entry stores only what an action changed,
+// never a copy of the level. Moves, id changes and adds are undone in time proportional to
+// the objects they touched. Deletes and reorders also have to shift the objects drawn above
+// the lowest one touched (or below the highest, for move to back) to keep the drawing order,
+// so they are O(n) in the layer at worst, when that object is at the bottom.
+class Undo
+{
+public:
+	enum actionType { MOVE, CHANGE_ID, ADD, DELETE, MOVE_TO_FRONT, MOVE_TO_BACK, RESIZE };
+
+	class Entry
+	{
+	public:
+		actionType action;
+
+		// Sorted by layer then position, except for ADD where they are in the order the objects were added
+		std::vector<Level::Object::Index> indexes;
+		std::vector<Level::Object> objects; // ADD: objects added, DELETE: objects removed, both at their real positions
+		std::vector<Uint16> oldIds, newIds; // CHANGE_ID
+
+		int delta_x, delta_y; // MOVE and RESIZE
+		bool shiftLevel; // RESIZE
+		Sint16 oldCameraX, oldCameraY; // RESIZE
+
+		Entry(actionType action) : action(action), delta_x(0), delta_y(0), shiftLevel(false), oldCameraX(0), oldCameraY(0) { }
+
+		size_t memoryUsed(void) const;
+	};
+
+	void recordMove(const Selection &selection, int delta_x, int delta_y, bool merge);
+	void recordIdChange(const std::vector<Level::Object::Index> &indexes, const std::vector<Uint16> &oldIds, const std::vector<Uint16> &newIds);
+	void recordAdd(const std::vector<Level::Object::Index> &indexes, const std::vector<Level::Object> &objects);
+	void recordDelete(const std::vector<Level::Object::Index> &indexes, const std::vector<Level::Object> &objects);
+	void recordReorder(const std::vector<Level::Object::Index> &indexes, bool toFront);
+	void recordResize(int delta_x, int delta_y, bool shiftLevel, Sint16 oldCameraX, Sint16 oldCameraY);
+
+	// Stops the next move being merged into the last one, call when a drag ends
+	void seal(void);
+
+	// Both fill affected with the objects the action touched, so they can be reselected
+	bool undo(Level &level, std::vector<Level::Object::Index> &affected);
+	bool redo(Level &level, std::vector<Level::Object::Index> &affected);
+
+	bool canUndo(void) const { return !done.empty(); }
+	bool canRedo(void) const { return !undone.empty(); }
+
+	void clear(void);
+	void setMemoryBudget(size_t bytes);
+
+	Undo(void);
+
+private:
+	std::deque<Entry> done;
+	std::vector<Entry> undone;
+	size_t memoryUsed;
+	size_t memoryBudget;
+	bool mergeOpen;
+
+	void push(const Entry &entry);
+	void trim(void);
+
+	static void apply(Level &level, const Entry &entry, bool forwards, std::vector<Level::Object::Index> &affected);
+};
+
+#endif // UNDO_HPP
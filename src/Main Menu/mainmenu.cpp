@@ -28,6 +28,8 @@ This file handles the main menu
 #include "../ini.hpp"
 #include "../lem3edit.hpp"
 #include "../tinyfiledialogs.h"
+#include "../trace.hpp"
+#include "../transaction.hpp"
 #include "../window.hpp"
 
 #include "SDL.h"
@@ -48,62 +50,47 @@ Mainmenu::Mainmenu(Ini * i, Editor * e)
 
 	lastFrameTick = 0;
 
-	//main menu text textures
-	TTF_Font * bigFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 70);
-	titleText = Font::createTextureFromString(bigFont, "Lem3edit");
-	loadingText = Font::createTextureFromString(bigFont, "LOADING");
-	TTF_CloseFont(bigFont);
-
-	//dialog text textures
-	TTF_Font * buttonFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 30);
-	NewLevelText = Font::createTextureFromString(buttonFont, "New Single Level");
-	LoadLevelText = Font::createTextureFromString(buttonFont, "Load Single Level");
-	CopyLevelText = Font::createTextureFromString(buttonFont, "Copy or Re-number Single Level");
-	DeleteLevelText = Font::createTextureFromString(buttonFont, "Delete Single Level");
-	NewPackText = Font::createTextureFromString(buttonFont, "New Level Pack");
-	LoadPackText = Font::createTextureFromString(buttonFont, "Load Level Pack");
-	PreviousPackText = NULL;
+	//main menu text
+	titleText = Font::Label(70, "Lem3edit");
+	loadingText = Font::Label(70, "LOADING");
+
+	//dialog text
+	NewLevelText = Font::Label(30, "New Single Level");
+	LoadLevelText = Font::Label(30, "Load Single Level");
+	CopyLevelText = Font::Label(30, "Copy or Re-number Single Level");
+	DeleteLevelText = Font::Label(30, "Delete Single Level");
+	NewPackText = Font::Label(30, "New Level Pack");
+	LoadPackText = Font::Label(30, "Load Level Pack");
 	refreshPreviousPackText();
-	QuitText = Font::createTextureFromString(buttonFont, "Quit");
-	TTF_CloseFont(buttonFont);
-
-	TTF_Font * smallFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 20);
-	for (int i = 0; i < 10; i++)
-	{
-		char digit[2] = "0";
-		digit[0] += i;
-		numbers[i] = Font::createTextureFromString(smallFont, digit);
-	}
-	OKText = Font::createTextureFromString(smallFont, "OK");
-	CancelText = Font::createTextureFromString(smallFont, "Cancel");
-	selectTribeText = Font::createTextureFromString(smallFont, "Select Tribe:");
-	classicTribeText = Font::createTextureFromString(smallFont, "CLASSIC");
-	shadowTribeText = Font::createTextureFromString(smallFont, "SHADOW");
-	egyptTribeText = Font::createTextureFromString(smallFont, "EGYPT");
-	newLevelIDText = Font::createTextureFromString(smallFont, "Level ID: ");
-	levelIDClassicText = Font::createTextureFromString(smallFont, "001 - 030: Classic Levels");
-	levelIDShadowText = Font::createTextureFromString(smallFont, "101 - 130: Shadow Levels");
-	levelIDEgyptText = Font::createTextureFromString(smallFont, "201 - 230: Egypt Levels");
-	levelIDPracticeText = Font::createTextureFromString(smallFont, "990      : Practice Level");
-	levelIDDemoText = Font::createTextureFromString(smallFont, "995 - 999: Demo Levels");
-	copyText = Font::createTextureFromString(smallFont, "Make a copy");
-	renumberText = Font::createTextureFromString(smallFont, "Re-number (deletes original files)");
-	TTF_CloseFont(smallFont);
+	QuitText = Font::Label(30, "Quit");
+
+	OKText = Font::Label(20, "OK");
+	CancelText = Font::Label(20, "Cancel");
+	selectTribeText = Font::Label(20, "Select Tribe:");
+	classicTribeText = Font::Label(20, "CLASSIC");
+	shadowTribeText = Font::Label(20, "SHADOW");
+	egyptTribeText = Font::Label(20, "EGYPT");
+	newLevelIDText = Font::Label(20, "Level ID: ");
+	levelIDClassicText = Font::Label(20, "001 - 030: Classic Levels");
+	levelIDShadowText = Font::Label(20, "101 - 130: Shadow Levels");
+	levelIDEgyptText = Font::Label(20, "201 - 230: Egypt Levels");
+	levelIDPracticeText = Font::Label(20, "990      : Practice Level");
+	levelIDDemoText = Font::Label(20, "995 - 999: Demo Levels");
+	copyText = Font::Label(20, "Make a copy");
+	renumberText = Font::Label(20, "Re-number (deletes original files)");
 
 	menuDialog = NODIALOG;
 
 	level_id = 1;
 	fileOBS = { 1000, 1000 };
 
+	StartupTrace::phase("First frame");
 	draw();
+	StartupTrace::finish();
 }
 
 void Mainmenu::refreshPreviousPackText(void)
 {
-	if (PreviousPackText != NULL)
-		SDL_DestroyTexture(PreviousPackText);
-	PreviousPackText = NULL;
-
 	std::string s = "Load Last Pack: ";
 	if (fs::exists(ini_ptr->lastLoadedPack))
 	{
@@ -114,9 +101,7 @@ void Mainmenu::refreshPreviousPackText(void)
 		s += "None!";
 	}
 
-	TTF_Font * buttonFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 30);
-	PreviousPackText = Font::createTextureFromString(buttonFont, s);
-	TTF_CloseFont(buttonFont);
+	PreviousPackText = Font::Label(30, s);
 }
 
 void Mainmenu::handleMainMenuEvents(SDL_Event event)
@@ -644,28 +629,17 @@ void Mainmenu::draw(void)
 	SDL_RenderPresent(g_window.screen_renderer);
 }
 
-void Mainmenu::renderText(SDL_Texture * tex, const int x, const int topY, const renderAlign align)
+void Mainmenu::renderText(const Font::Label &l, const int x, const int topY, const renderAlign align)
 {
-	int textW, textH;
-	SDL_Rect textRect;
-
-	SDL_QueryTexture(tex, NULL, NULL, &textW, &textH);
-	if (align == CENTRE)
-		textRect.x = x - (textW / 2);
-	else
-		textRect.x = x;
-	textRect.y = topY;
-	textRect.w = textW;
-	textRect.h = textH;
-	SDL_RenderCopy(g_window.screen_renderer, tex, NULL, &textRect);
+	Font::drawString(l, x, topY, align == CENTRE ? Font::CENTRE : Font::LEFT);
 }
 
-void Mainmenu::renderButton(SDL_Texture * tex, const int centreX, const int topY, const bool highlight)
+void Mainmenu::renderButton(const Font::Label &l, const int centreX, const int topY, const bool highlight)
 {
-	int textW, textH;
+	int textW = Font::stringWidth(l.size, l.text);
+	int textH = Font::lineHeight(l.size);
 	SDL_Rect buttonRect;
 
-	SDL_QueryTexture(tex, NULL, NULL, &textW, &textH);
 	buttonRect.x = centreX - (textW / 2) - 2;
 	buttonRect.y = topY;
 	buttonRect.w = textW + 4;
@@ -679,42 +653,12 @@ void Mainmenu::renderButton(SDL_Texture * tex, const int centreX, const int topY
 	SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 	SDL_RenderDrawRect(g_window.screen_renderer, &buttonRect);
 
-	renderText(tex, centreX, topY + 2, CENTRE);
+	renderText(l, centreX, topY + 2, CENTRE);
 }
 
 void Mainmenu::renderNumbers(int num, const int rightX, const int y)
 {
-	int numChars[3];
-	int size = 0;
-	if (num == 0)
-	{
-		size = 1;
-		numChars[0] = 0;
-	}
-	else
-	{
-		while (num != 0)
-		{
-			//load number characters into array in reverse order
-			numChars[size] = num % 10;
-			num /= 10;
-			size++;
-		}
-	}
-
-	int textW, textH, drawX;
-	SDL_Rect textRect;
-	drawX = rightX;
-	for (int i = 0; i < size; i++)
-	{
-		SDL_QueryTexture(numbers[numChars[i]], NULL, NULL, &textW, &textH);
-		drawX -= textW;
-		textRect.x = drawX;
-		textRect.y = y;
-		textRect.w = textW;
-		textRect.h = textH;
-		SDL_RenderCopy(g_window.screen_renderer, numbers[numChars[i]], NULL, &textRect);
-	}
+	Font::drawString(20, std::to_string(num), rightX, y, Font::RIGHT);
 }
 
 bool Mainmenu::confirmOverwrite(fs::path filePath, int id)
@@ -891,33 +835,36 @@ void Mainmenu::copyLevel(void)
 		return;
 
 	fs::path sourcePath = filePath.parent_path();
-	fs::path fromPath;
-	fs::path toPath;
+	fs::path fromPaths[3] = {
+		filePath,
+		l3_filename_level(sourcePath, "TEMP", fileOBS.temp, "OBS"),
+		l3_filename_level(sourcePath, "PERM", fileOBS.perm, "OBS") };
+	fs::path toPaths[3] = {
+		destinationPath,
+		l3_filename_level(destinationPath.parent_path(), "TEMP", level_id, "OBS"),
+		l3_filename_level(destinationPath.parent_path(), "PERM", level_id, "OBS") };
+
+	//renumbering within a folder is just renames, otherwise copy and drop the originals afterwards
+	bool sameFolder = fs::equivalent(sourcePath, destinationPath.parent_path());
+	MoveTransaction moves(destinationPath.parent_path());
+	for (int i = 0; i < 3; i++)
+	{
+		if (!selectedCopy && sameFolder)
+			moves.move(fromPaths[i], toPaths[i]);
+		else
+			moves.copy(fromPaths[i], toPaths[i]);
+	}
+	if (!selectedCopy && !sameFolder)
+		for (int i = 0; i < 3; i++)
+			moves.remove(fromPaths[i]);
+	moves.setLevelId(destinationPath, level_id);
 
-	fromPath = filePath;
-	toPath = destinationPath;
-	fs::copy(fromPath, toPath);
-	if (!updateOBSValues(toPath, level_id))
+	if (!moves.commit())
 	{
-		tinyfd_messageBox("Oh No!", "Lem3edit could not update the temp and perm file references in the new level file for some reason!\n\nLevel copying aborted.", "ok", "error", 1);
+		tinyfd_messageBox("Oh No!", "Lem3edit could not copy the level files for some reason!\n\nLevel copying aborted.", "ok", "error", 1);
 		return;
 	}
 
-	if (!selectedCopy)
-		fs::remove(fromPath);
-
-	fromPath = l3_filename_level(sourcePath, "TEMP", fileOBS.temp, "OBS");
-	toPath = l3_filename_level(destinationPath.parent_path(), "TEMP", level_id, "OBS");
-	fs::copy(fromPath, toPath);
-	if (!selectedCopy)
-		fs::remove(fromPath);
-
-	fromPath = l3_filename_level(sourcePath, "PERM", fileOBS.perm, "OBS");
-	toPath = l3_filename_level(destinationPath.parent_path(), "PERM", level_id, "OBS");
-	fs::copy(fromPath, toPath);
-	if (!selectedCopy)
-		fs::remove(fromPath);
-
 	menuDialog = NODIALOG;
 }
 
@@ -22,6 +22,7 @@
 #define MAINMENU_HPP
 
 #include "packeditor.hpp"
+#include "../font.hpp"
 #include "../lem3edit.hpp"
 
 #include "SDL.h"
@@ -77,34 +78,33 @@ private:
 
 	tribeName selectedTribe;
 
-	// main menu text textures
-	SDL_Texture * titleText = NULL;
-	SDL_Texture * loadingText = NULL;
-	SDL_Texture * NewLevelText = NULL;
-	SDL_Texture * LoadLevelText = NULL;
-	SDL_Texture * CopyLevelText = NULL;
-	SDL_Texture * DeleteLevelText = NULL;
-	SDL_Texture * NewPackText = NULL;
-	SDL_Texture * LoadPackText = NULL;
-	SDL_Texture * PreviousPackText = NULL;
-	SDL_Texture * QuitText = NULL;
-
-	//dialog text textures
-	SDL_Texture * numbers[10] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-	SDL_Texture * OKText = NULL;
-	SDL_Texture * CancelText = NULL;
-	SDL_Texture * selectTribeText = NULL;
-	SDL_Texture * classicTribeText = NULL;
-	SDL_Texture * shadowTribeText = NULL;
-	SDL_Texture * egyptTribeText = NULL;
-	SDL_Texture * newLevelIDText = NULL;
-	SDL_Texture * levelIDClassicText = NULL;
-	SDL_Texture * levelIDShadowText = NULL;
-	SDL_Texture * levelIDEgyptText = NULL;
-	SDL_Texture * levelIDPracticeText = NULL;
-	SDL_Texture * levelIDDemoText = NULL;
-	SDL_Texture * copyText = NULL;
-	SDL_Texture * renumberText = NULL;
+	// main menu text
+	Font::Label titleText;
+	Font::Label loadingText;
+	Font::Label NewLevelText;
+	Font::Label LoadLevelText;
+	Font::Label CopyLevelText;
+	Font::Label DeleteLevelText;
+	Font::Label NewPackText;
+	Font::Label LoadPackText;
+	Font::Label PreviousPackText;
+	Font::Label QuitText;
+
+	//dialog text
+	Font::Label OKText;
+	Font::Label CancelText;
+	Font::Label selectTribeText;
+	Font::Label classicTribeText;
+	Font::Label shadowTribeText;
+	Font::Label egyptTribeText;
+	Font::Label newLevelIDText;
+	Font::Label levelIDClassicText;
+	Font::Label levelIDShadowText;
+	Font::Label levelIDEgyptText;
+	Font::Label levelIDPracticeText;
+	Font::Label levelIDDemoText;
+	Font::Label copyText;
+	Font::Label renumberText;
 
 	void refreshPreviousPackText(void);
 
@@ -112,8 +112,8 @@ private:
 
 	enum renderAlign { LEFT, CENTRE };
 
-	void renderText(SDL_Texture * tex, const int x, const int topY, const renderAlign align);
-	void renderButton(SDL_Texture * tex, const int centreX, const int topY, const bool highlight);
+	void renderText(const Font::Label &l, const int x, const int topY, const renderAlign align);
+	void renderButton(const Font::Label &l, const int centreX, const int topY, const bool highlight);
 	void renderNumbers(int num, const int rightX, const int y);
 
 	int level_id;
@@ -24,15 +24,21 @@ This file handles the level pack editor
 
 #include "mainmenu.hpp"
 #include "packeditor.hpp"
+#include "../batch.hpp"
 #include "../Editor/editor.hpp"
 #include "../font.hpp"
 #include "../ini.hpp"
 #include "../tinyfiledialogs.h"
+#include "../transaction.hpp"
 
 #include "SDL.h"
 #include "SDL_ttf.h"
 
+#include <cctype>
+#include <cstdlib>
 #include <fstream>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <experimental/filesystem>
@@ -41,26 +47,16 @@ namespace fs = std::experimental::filesystem::v1;
 
 PackEditor::PackEditor(void)
 {
-	//load font graphics
+	//text labels, drawn from the shared glyph atlas
 	{
-		TTF_Font * bigFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 30);
-		classicTabTex = Font::createTextureFromString(bigFont, "CLASSIC");
-		shadowTabTex = Font::createTextureFromString(bigFont, "SHADOW");
-		egyptTabTex = Font::createTextureFromString(bigFont, "EGYPT");
-		TTF_CloseFont(bigFont);
-
-		TTF_Font * smallFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 20);
-		for (int i = 0; i < 10; i++)
-		{
-			char digit[2] = "0";
-			digit[0] += i;
-			numbers[i] = Font::createTextureFromString(smallFont, digit);
-		}
-		addNewLevelTex = Font::createTextureFromString(smallFont, "Add New Level");
-		loadLevelTex = Font::createTextureFromString(smallFont, "Load Level");
-		totalLemsTex = Font::createTextureFromString(smallFont, "Total Lemmings:");
-		quitTex = Font::createTextureFromString(smallFont, "Quit");
-		TTF_CloseFont(smallFont);
+		classicTab = Font::Label(30, "CLASSIC");
+		shadowTab = Font::Label(30, "SHADOW");
+		egyptTab = Font::Label(30, "EGYPT");
+
+		addNewLevelLabel = Font::Label(20, "Add New Level");
+		loadLevelLabel = Font::Label(20, "Load Level");
+		totalLemsLabel = Font::Label(20, "Total Lemmings:");
+		quitLabel = Font::Label(20, "Quit");
 	}
 
 	//load button graphics
@@ -120,16 +116,9 @@ PackEditor::PackEditor(void)
 	}
 }
 
-void PackEditor::refreshTitleTexture(void)
+void PackEditor::refreshTitle(void)
 {
-	if (packTitleTex != NULL)
-		SDL_DestroyTexture(packTitleTex);
-	if (packPath.has_filename())
-	{
-		TTF_Font * bigFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 30);
-		packTitleTex = Font::createTextureFromString(bigFont, packPath.stem().generic_string());
-		TTF_CloseFont(bigFont);
-	}
+	packTitle = Font::Label(30, packPath.has_filename() ? packPath.stem().generic_string() : "");
 }
 
 void PackEditor::setReferences(Ini * i, Editor * e, Mainmenu * m)
@@ -191,71 +180,63 @@ void PackEditor::handlePackEditorEvents(SDL_Event event)
 
 			if (mouse_y_window + 26 < g_window.height - 35)
 			{
-				for (int i = 0; i < levels[tribeTab].size(); i++)
+				//only the row under the mouse needs checking
+				const int i = rowAtY(mouse_y_window);
+				if (i != -1 && i + scroll[tribeTab] < levels[tribeTab].size())
 				{
-					if (i + scroll[tribeTab] >= levels[tribeTab].size())
+					//moveUp button
+					if (mouse_x_window > g_window.width - 197 && mouse_x_window < g_window.width - 171)
 					{
-						break;
+						int n = i + 1 + scroll[tribeTab];
+						swapLevelPosition(n, n - 1, tribeTab);
 					}
-					//level entry line
-					if (mouse_y_window > 88 + (i * 30) && mouse_y_window < 114 + (i * 30))
-					{
-						//moveUp button
-						if (mouse_x_window > g_window.width - 197 && mouse_x_window < g_window.width - 171)
-						{
-							int n = i + 1 + scroll[tribeTab];
-							swapLevelPosition(n, n - 1, tribeTab);
-						}
 
-						//moveDown button
-						if (mouse_x_window > g_window.width - 167 && mouse_x_window < g_window.width - 141)
-						{
-							int n = i + 1 + scroll[tribeTab];
-							swapLevelPosition(n, n + 1, tribeTab);
-						}
+					//moveDown button
+					if (mouse_x_window > g_window.width - 167 && mouse_x_window < g_window.width - 141)
+					{
+						int n = i + 1 + scroll[tribeTab];
+						swapLevelPosition(n, n + 1, tribeTab);
+					}
 
-						//edit button
-						if (mouse_x_window > g_window.width - 137 && mouse_x_window < g_window.width - 111)
-						{
-							int id = i + 1 + scroll[tribeTab] + (tribeTab * 100);
-							menu_ptr->drawLoadingBanner();
-							g_currentMode = EDITORMODE;
-							redraw = true;
-							refreshID = id;
-							editor_ptr->load(l3_filename_level(packPath.parent_path(), "LEVEL", id, "DAT"), LEVELPACKMODE);
-						}
+					//edit button
+					if (mouse_x_window > g_window.width - 137 && mouse_x_window < g_window.width - 111)
+					{
+						int id = i + 1 + scroll[tribeTab] + (tribeTab * 100);
+						menu_ptr->drawLoadingBanner();
+						g_currentMode = EDITORMODE;
+						redraw = true;
+						editor_ptr->load(l3_filename_level(packPath.parent_path(), "LEVEL", id, "DAT"), LEVELPACKMODE);
+					}
 
-						//rename button
-						if (mouse_x_window > g_window.width - 107 && mouse_x_window < g_window.width - 81)
+					//rename button
+					if (mouse_x_window > g_window.width - 107 && mouse_x_window < g_window.width - 81)
+					{
+						char const * getRename = tinyfd_inputBox(
+							"Rename Level",
+							"Choose a new name for the level.",
+							levels[tribeTab][i + scroll[tribeTab]].name.c_str());
+						if (getRename != NULL)
 						{
-							char const * getRename = tinyfd_inputBox(
-								"Rename Level",
-								"Choose a new name for the level.",
-								levels[tribeTab][i + scroll[tribeTab]].name.c_str());
-							if (getRename != NULL)
-							{
-								std::string s = getRename;
-								if (!s.empty() && s[s.length() - 1] == '\n') {
-									s.erase(s.length() - 1);
-								}
-								levels[tribeTab][i + scroll[tribeTab]].name = s;
-								levels[tribeTab][i + scroll[tribeTab]].refreshTexture();
-								save();
-								redraw = true;
+							std::string s = getRename;
+							if (!s.empty() && s[s.length() - 1] == '\n') {
+								s.erase(s.length() - 1);
 							}
+							levels[tribeTab][i + scroll[tribeTab]].name = s;
+							save();
+							redraw = true;
 						}
+					}
 
-						//save as button
-						if (mouse_x_window > g_window.width - 77 && mouse_x_window < g_window.width - 51)
-						{
-							saveLevel(i + 1 + scroll[tribeTab], tribeTab);
-						}
+					//save as button
+					if (mouse_x_window > g_window.width - 77 && mouse_x_window < g_window.width - 51)
+					{
+						saveLevel(i + 1 + scroll[tribeTab], tribeTab);
+					}
 
-						//delete button
-						if (mouse_x_window > g_window.width - 47 && mouse_x_window < g_window.width - 21)
-						{
-							deleteLevel(i + 1 + scroll[tribeTab], tribeTab);
-						}
+					//delete button
+					if (mouse_x_window > g_window.width - 47 && mouse_x_window < g_window.width - 21)
+					{
+						deleteLevel(i + 1 + scroll[tribeTab], tribeTab);
 					}
 				}
 
@@ -284,6 +265,7 @@ void PackEditor::handlePackEditorEvents(SDL_Event event)
 				mouse_y_window < g_window.height - 4)
 			{
 				save();
+				watcher.stop();
 				g_currentMode = MAINMENUMODE;
 			}
 		}
@@ -295,19 +277,9 @@ void PackEditor::handlePackEditorEvents(SDL_Event event)
 		if (!mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT))
 		{
 			if (e.y == 1)
-			{
-				scroll[tribeTab] --;
-				if (scroll[tribeTab] < 0)
-					scroll[tribeTab] = 0;
-				redraw = true;
-			}
+				scrollBy(-1);
 			if (e.y == -1)
-			{
-				scroll[tribeTab] ++;
-				if (scroll[tribeTab] >= levels[tribeTab].size())
-					scroll[tribeTab] = levels[tribeTab].size() - 1;
-				redraw = true;
-			}
+				scrollBy(1);
 		}
 		break;
 	}
@@ -318,20 +290,15 @@ void PackEditor::handlePackEditorEvents(SDL_Event event)
 		switch (e.keysym.sym)
 		{
 		case SDLK_UP:
-			scroll[tribeTab] --;
-			if (scroll[tribeTab] < 0)
-				scroll[tribeTab] = 0;
-			redraw = true;
+			scrollBy(-1);
 			break;
 		case SDLK_DOWN:
-			scroll[tribeTab] ++;
-			if (scroll[tribeTab] >= levels[tribeTab].size())
-				scroll[tribeTab] = levels[tribeTab].size() - 1;
-			redraw = true;
+			scrollBy(1);
 			break;
 		case SDLK_ESCAPE:
 		case SDLK_q:
 			save();
+			watcher.stop();
 			g_currentMode = MAINMENUMODE;
 			break;
 		default:
@@ -345,6 +312,7 @@ void PackEditor::handlePackEditorEvents(SDL_Event event)
 		lastFrameTick = SDL_GetTicks();
 		if (ticksSinceLastFrame <= 36 && ticksSinceLastFrame >= 30)
 		{
+			refreshChangedLevels();
 			draw();
 		}
 		break;
@@ -406,7 +374,9 @@ bool PackEditor::create(void)
 	packFile.close();
 
 	clearLevels();
-	refreshTitleTexture();
+	refreshTitle();
+	index.load(packPath);
+	watcher.start(std::vector<fs::path>(1, packPath.parent_path()));
 
 	//autoload levels
 	if (autoLoad)
@@ -469,6 +439,7 @@ bool PackEditor::create(void)
 				}
 			}
 		}
+		index.save();
 	}
 
 	version = CURRENTPACKFILEVERSION;
@@ -493,82 +464,45 @@ bool PackEditor::load(const fs::path fileName)
 	}
 
 	packPath = fileName;
-	fs::path packParent = packPath.parent_path();
-	std::ifstream packFile(packPath, std::ios::out);
 
-	if (!packFile.is_open())
+	//list the pack folder once and read every level header together, rather than checking each file in turn,
+	//taking the headers of unchanged levels from the pack index
+	LevelBatch batch;
+	if (!batch.find(packPath))
 	{
-		SDL_Log("load: Couldn't open level pack %s\n.", fileName.generic_string().c_str());
+		//TODO: handle invalid pack file entry
 		return false;
 	}
-	std::string line;
-	std::string key;
-	std::string value;
+	version = batch.version;
 
-	int count = 1;
-
-	while (getline(packFile, line))
+	for (std::vector<LevelBatch::Item>::const_iterator iter = batch.items.begin(); iter != batch.items.end(); ++iter)
 	{
-		std::string::size_type pos = line.find('=');
-		if (pos != std::string::npos)
+		if (!batch.hasLevelFiles(iter->id))
 		{
-			key = line.substr(0, pos);
-
-			if (key == "VERSION")
-			{
-				//load pack version so we can handle backwards compatability if the format ever changes
-				version = atoi(value.c_str());
-				continue;
-			}
-
-			int id = atoi(key.c_str());
-			value = line.substr(pos + 1);
-
-			tribeName loadingTribe;
-			if (id >= 1 && id <= 30)
-				loadingTribe = CLASSIC;
-			else if (id >= 101 && id <= 130)
-				loadingTribe = SHADOW;
-			else if (id >= 201 && id <= 230)
-				loadingTribe = EGYPT;
-			else
-			{
-				packFile.close();
-				SDL_Log("load: Invalid pack file entry - Invalid id");
-				//TODO: handle invalid pack file entry
-				return false;
-			}
-
-			count++;
-			if (id % 100 == 1)
-				count = 1 + (loadingTribe * 100);
-
-			if (id != count)
-			{
-				packFile.close();
-				SDL_Log("load: Invalid pack file entry - Level id out of order");
-				//TODO: handle invalid pack file entry
-				return false;
-			}
-
-			if (!levelExists(id))
-			{
-				packFile.close();
-				SDL_Log("load: Invalid pack file entry - Not all parts of level %d could be found!", id);
-				//TODO: handle level fies not matching id
-
-				return false;
-			}
-
-			int lems = loadLemsFromFile(id % 100, loadingTribe);
-			levels[loadingTribe].emplace_back(levelData(value, lems));
+			SDL_Log("load: Invalid pack file entry - Not all parts of level %d could be found!", iter->id);
+			//TODO: handle level fies not matching id
+			return false;
 		}
 	}
 
-	packFile.close();
+	index.load(packPath);
+	watcher.start(std::vector<fs::path>(1, packPath.parent_path()));
+	index.fill(batch);
+
+	for (std::vector<LevelBatch::Item>::const_iterator iter = batch.items.begin(); iter != batch.items.end(); ++iter)
+	{
+		const LevelBatch::Item &item = *iter;
+
+		int lems = -1;
+		if (!item.header.empty())
+			lems = item.header[0x16];
+		else
+			SDL_Log("load: Failed to read the header of level %d\n", item.id);
+		levels[item.tribe].emplace_back(levelData(item.name, lems));
+	}
 
 	refreshLemCounts();
-	refreshTitleTexture();
+	refreshTitle();
 	tribeTab = CLASSIC;
 
 	g_currentMode = LEVELPACKMODE;
@@ -586,8 +520,17 @@ bool PackEditor::save(void)
 		return false;
 	}
 
+	packFile << packListing();
+	packFile.close();
+	return true;
+}
+
+std::string PackEditor::packListing(void) const
+{
+	std::ostringstream listing;
+
 	//always save as latest version at top of file
-	packFile << "VERSION=" << CURRENTPACKFILEVERSION << std::endl;
+	listing << "VERSION=" << CURRENTPACKFILEVERSION << std::endl;
 
 	for (int i = 0; i < TRIBECOUNT; i++)
 	{
@@ -597,11 +540,10 @@ bool PackEditor::save(void)
 			const levelData &data = *iter;
 			count++;
 			int id = (i * 100) + count;
-			packFile << id << "=" << data.name << std::endl;
+			listing << id << "=" << data.name << std::endl;
 		}
 	}
-	packFile.close();
-	return true;
+	return listing.str();
 }
 
 void PackEditor::createLevel(const int n, const tribeName t)
@@ -806,6 +748,7 @@ void PackEditor::loadLevel(const int n, const tribeName t)
 
 	int lems;
 	lems = loadLemsFromFile(n, t);
+	index.save();
 
 	std::string name;
 	name = "Loaded Level ";
@@ -872,35 +815,12 @@ void PackEditor::deleteLevel(const int n, const tribeName t)
 	if (answer == 0)
 		return;
 
-	int level_id = n + (t * 100);
-
-	fs::remove(l3_filename_level(packPath.parent_path(), "LEVEL", level_id, "DAT"));
-	fs::remove(l3_filename_level(packPath.parent_path(), "TEMP", level_id, "OBS"));
-	fs::remove(l3_filename_level(packPath.parent_path(), "PERM", level_id, "OBS"));
-	levels[t].erase(levels[t].begin() + n - 1);
-
-	for (int i = n + 1; i < levels[t].size() + 2; i++)
-	{
-		fs::path datPath = l3_filename_level(packPath.parent_path(), "LEVEL", i, "DAT");
-		if (!Mainmenu::updateOBSValues(datPath, i - 1))
-		{
-			tinyfd_messageBox("Oh No!", "Lem3edit could not update the temp and perm file references in the new level file for some reason!\n\nLevel reorganising aborted.", "ok", "error", 1);
-			return;
-		}
-		fs::path destinationPath = l3_filename_level(packPath.parent_path(), "LEVEL", i - 1, "DAT");
-		fs::rename(datPath, destinationPath);
-
-		fs::path tempPath = l3_filename_level(packPath.parent_path(), "TEMP", i, "OBS");
-		destinationPath = l3_filename_level(packPath.parent_path(), "TEMP", i - 1, "OBS");
-		fs::rename(tempPath, destinationPath);
-
-		fs::path permPath = l3_filename_level(packPath.parent_path(), "PERM", i, "OBS");
-		destinationPath = l3_filename_level(packPath.parent_path(), "PERM", i - 1, "OBS");
-		fs::rename(permPath, destinationPath);
-	}
+	std::vector<int> order;
+	for (int i = 1; i <= (int)levels[t].size(); i++)
+		if (i != n)
+			order.push_back(i);
 
-	save();
-	redraw = true;
+	rearrangeLevels(t, order);
 }
 
 bool PackEditor::levelExists(const int id)
@@ -922,29 +842,12 @@ PackEditor::levelData::levelData(const std::string s, const int n)
 {
 	name = s;
 	lems = n;
-	tex = NULL;
-	refreshTexture();
-}
-
-void PackEditor::levelData::refreshTexture(void)
-{
-	if (tex != NULL)
-		SDL_DestroyTexture(tex);
-	TTF_Font * smallFont = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", 20);
-	tex = Font::createTextureFromString(smallFont, name);
-	TTF_CloseFont(smallFont);
 }
 
 void PackEditor::clearLevels(void)
 {
 	for (int i = 0; i < TRIBECOUNT; i++)
 	{
-		for (std::vector<levelData>::iterator iter = levels[i].begin(); iter != levels[i].end(); ++iter)
-		{
-			levelData &data = *iter;
-			if (data.tex != NULL)
-				SDL_DestroyTexture(data.tex);
-		}
 		levels[i].clear();
 		totalLems[i] = 20;
 		scroll[i] = 0;
@@ -954,27 +857,16 @@ void PackEditor::clearLevels(void)
 int PackEditor::loadLemsFromFile(const int n, const tribeName t)
 {
 	int level_id = n + (t * 100);
-	fs::path loadPath = l3_filename_level(packPath.parent_path(), "LEVEL", level_id, "DAT");
-	if (!fs::exists(loadPath))
-	{
-		SDL_Log("loadLemsFromFile: Tried to load lemming count but level %d doesn't exist!\n", level_id);
-		return -1;
-	}
 
-	std::ifstream f(loadPath, std::ios::binary | std::ios::in);
-	if (!f)
+	//only reads the file if it changed since the pack index last saw it
+	const PackIndex::Entry * entry = index.level(level_id);
+	if (entry == NULL)
 	{
-		SDL_Log("loadLemsFromFile: Failed to open '%s'\n", loadPath.generic_string().c_str());
+		SDL_Log("loadLemsFromFile: Tried to load lemming count but level %d doesn't exist!\n", level_id);
 		return -1;
 	}
 
-	Uint8 lems;
-
-	f.seekg(0x16);
-	f.read((char *)&lems, sizeof(lems));
-	f.close();
-
-	return lems;
+	return entry->header[0x16];
 }
 
 void PackEditor::refreshLemCounts(void)
@@ -992,38 +884,89 @@ void PackEditor::refreshLemCounts(void)
 	}
 }
 
-void PackEditor::draw(void)
+void PackEditor::refreshChangedLevels(void)
 {
-	if (redraw == false)
+	std::set<fs::path> changed;
+	if (!watcher.takeChanges(changed))
 		return;
 
-	//refresh a level lemming count if an ID is stored.
-	if (refreshID != 0)
+	bool any = false;
+	for (std::set<fs::path>::const_iterator iter = changed.begin(); iter != changed.end(); ++iter)
+	{
+		//only LEVEL###.DAT holds the lemming count
+		const std::string name = iter->filename().generic_string();
+		if (name.size() != 12 || name.compare(0, 5, "LEVEL") != 0 || name.compare(8, 4, ".DAT") != 0)
+			continue;
+		if (!isdigit(name[5]) || !isdigit(name[6]) || !isdigit(name[7]))
+			continue;
+
+		int id = atoi(name.substr(5, 3).c_str());
+		int n = id % 100;
+		int t = id / 100;
+		if (t >= TRIBECOUNT || n < 1 || n > (int)levels[t].size())
+			continue;
+
+		int lems = loadLemsFromFile(n, (tribeName)t);
+		if (lems != levels[t][n - 1].lems)
+		{
+			levels[t][n - 1].lems = lems;
+			any = true;
+		}
+	}
+	index.save();
+
+	if (any)
 	{
-		tribeName refreshTribe;
-		int id = refreshID % 100;
-		int t = refreshID / 100;
-		if (t == 0)
-			refreshTribe = CLASSIC;
-		else if (t == 1)
-			refreshTribe = SHADOW;
-		else if (t == 2)
-			refreshTribe = EGYPT;
-		levels[t][id - 1].lems = loadLemsFromFile(id, refreshTribe);
 		refreshLemCounts();
-		refreshID = 0;
+		redraw = true;
 	}
+}
+
+void PackEditor::scrollBy(const int rows)
+{
+	int last = std::max((int)levels[tribeTab].size() - 1, 0);
+	scroll[tribeTab] = BETWEEN(0, scroll[tribeTab] + rows, last);
+	redrawList = true;
+}
+
+int PackEditor::visibleRows(void) const
+{
+	//rows start at 90, are 30 apart and must end above the bottom bar
+	int space = g_window.height - 35 - 26 - 90;
+	if (space < 0)
+		return 0;
+	return (space / 30) + 1;
+}
+
+int PackEditor::rowAtY(const int y) const
+{
+	int offset = y - 88;
+	if (offset <= 0 || offset % 30 == 0 || offset % 30 >= 26)
+		return -1;
+
+	int row = offset / 30;
+	if (row >= visibleRows())
+		return -1;
+	return row;
+}
+
+void PackEditor::draw(void)
+{
+	if (redraw == false && redrawList == false)
+		return;
 
 	int centreX = g_window.width / 2;
 	int windowThird = g_window.width / 3;
 	SDL_SetRenderDrawBlendMode(g_window.screen_renderer, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderTarget(g_window.screen_renderer, g_window.screen_texture);
-	SDL_SetRenderDrawColor(g_window.screen_renderer, 240, 240, 240, 255);
-	SDL_RenderClear(g_window.screen_renderer);
 
-	//title and tabs
+	//title and tabs, left alone when only the list changed
+	if (redraw)
 	{
-		renderText(packTitleTex, centreX, 4, CENTRE, 0);
+		SDL_SetRenderDrawColor(g_window.screen_renderer, 240, 240, 240, 255);
+		SDL_RenderClear(g_window.screen_renderer);
+
+		renderText(packTitle, centreX, 4, CENTRE, 0);
 		SDL_Rect r;
 
 		r.x = 4;
@@ -1039,7 +982,7 @@ void PackEditor::draw(void)
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 80, 200, 70, 255);
 			SDL_RenderDrawLine(g_window.screen_renderer, 5, 75, (2 + windowThird), 75);
 		}
-		renderText(classicTabTex, (g_window.width / 6), 40, CENTRE, 0);
+		renderText(classicTab, (g_window.width / 6), 40, CENTRE, 0);
 
 		r.x = 3 + windowThird;
 		r.y = 36;
@@ -1054,7 +997,7 @@ void PackEditor::draw(void)
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 130, 140, 200, 255);
 			SDL_RenderDrawLine(g_window.screen_renderer, 4 + windowThird, 75, (1 + (windowThird * 2)), 75);
 		}
-		renderText(shadowTabTex, centreX, 40, CENTRE, 0);
+		renderText(shadowTab, centreX, 40, CENTRE, 0);
 
 		r.x = (g_window.width - windowThird - 2);
 		r.y = 36;
@@ -1069,8 +1012,12 @@ void PackEditor::draw(void)
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 250, 230, 120, 255);
 			SDL_RenderDrawLine(g_window.screen_renderer, g_window.width - windowThird - 1, 75, (g_window.width - 4), 75);
 		}
-		renderText(egyptTabTex, (g_window.width / 6) * 5, 40, CENTRE, 0);
+		renderText(egyptTab, (g_window.width / 6) * 5, 40, CENTRE, 0);
+	}
 
+	//levels, only the rows in view
+	{
+		SDL_Rect r;
 		r.x = 4;
 		r.y = 76;
 		r.w = g_window.width - 7;
@@ -1086,27 +1033,14 @@ void PackEditor::draw(void)
 		SDL_RenderDrawLine(g_window.screen_renderer, r.x, r.y, r.x, r.y + r.h); //left border
 		SDL_RenderDrawLine(g_window.screen_renderer, r.x, r.y + r.h, r.x + r.w, r.y + r.h); //bottom border
 		SDL_RenderDrawLine(g_window.screen_renderer, r.x + r.w, r.y, r.x + r.w, r.y + r.h); // right border
-	}
 
-	//levels
-	{
+		const int first = std::max(scroll[tribeTab], 0);
+		const int last = std::min((int)levels[tribeTab].size(), first + visibleRows());
 		int yPos = 90;
-		int count = 1;
-		for (std::vector<levelData>::const_iterator iter = levels[tribeTab].begin(); iter != levels[tribeTab].end(); ++iter)
+		for (int n = first; n < last; n++)
 		{
-			if (count <= scroll[tribeTab])
-			{
-				count++;
-				continue;//don't process the first X
-			}
-			if (yPos + 26 > g_window.height - 35)
-			{
-				break;//stop processing once at the bottom of the tab
-			}
-
-			const levelData &d = *iter;
+			const levelData &d = levels[tribeTab][n];
 
-			SDL_Rect r;
 			r.x = 8;
 			r.y = (yPos - 2);
 			r.w = (g_window.width - 210);
@@ -1117,8 +1051,8 @@ void PackEditor::draw(void)
 			SDL_RenderDrawRect(g_window.screen_renderer, &r);
 			SDL_RenderDrawLine(g_window.screen_renderer, g_window.width - 245, r.y, g_window.width - 245, r.y + r.h - 1);
 
-			renderNumbers(count, 35, yPos);
-			renderText(d.tex, 45, yPos, LEFT, g_window.width - 295);
+			renderNumbers(n + 1, 35, yPos);
+			Font::drawString(20, d.name, 45, yPos, Font::LEFT, g_window.width - 295);
 			renderNumbers(d.lems, g_window.width - 210, yPos);
 
 			r.x = g_window.width - 197;
@@ -1143,11 +1077,9 @@ void PackEditor::draw(void)
 			SDL_RenderCopy(g_window.screen_renderer, deleteButtonTex, NULL, &r);
 
 			yPos += 30;
-			count++;
 		}
-		if (count < 30 && yPos + 26 < g_window.height - 35)
+		if (last + 1 < 30 && yPos + 26 < g_window.height - 35)
 		{
-			SDL_Rect r;
 			r.x = windowThird - 100;
 			r.y = (yPos - 2);
 			r.w = 200;
@@ -1156,7 +1088,7 @@ void PackEditor::draw(void)
 			SDL_RenderFillRect(g_window.screen_renderer, &r);
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 			SDL_RenderDrawRect(g_window.screen_renderer, &r);
-			renderText(addNewLevelTex, windowThird, yPos, CENTRE, 0);
+			renderText(addNewLevelLabel, windowThird, yPos, CENTRE, 0);
 
 			r.x = (windowThird * 2) - 100;
 			r.y = (yPos - 2);
@@ -1166,11 +1098,12 @@ void PackEditor::draw(void)
 			SDL_RenderFillRect(g_window.screen_renderer, &r);
 			SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 			SDL_RenderDrawRect(g_window.screen_renderer, &r);
-			renderText(loadLevelTex, windowThird * 2, yPos, CENTRE, 0);
+			renderText(loadLevelLabel, windowThird * 2, yPos, CENTRE, 0);
 		}
 	}
 
 	//bottom bar
+	if (redraw)
 	{
 		SDL_Rect r;
 		r.x = 20;
@@ -1179,9 +1112,9 @@ void PackEditor::draw(void)
 		r.h = 26;
 		SDL_SetRenderDrawColor(g_window.screen_renderer, 0, 0, 0, 255);
 		SDL_RenderDrawRect(g_window.screen_renderer, &r);
-		renderText(quitTex, 70, g_window.height - 30, CENTRE, 0);
+		renderText(quitLabel, 70, g_window.height - 30, CENTRE, 0);
 
-		renderText(totalLemsTex, g_window.width - 435, g_window.height - 30, LEFT, 0);
+		renderText(totalLemsLabel, g_window.width - 435, g_window.height - 30, LEFT, 0);
 		renderNumbers(totalLems[tribeTab], g_window.width - 210, g_window.height - 30);
 	}
 
@@ -1190,69 +1123,17 @@ void PackEditor::draw(void)
 	SDL_RenderPresent(g_window.screen_renderer);
 
 	redraw = false;
+	redrawList = false;
 }
 
-void PackEditor::renderText(SDL_Texture * tex, const int x, const int topY, renderAlign align, const int restrictWidth)
+void PackEditor::renderText(const Font::Label &l, const int x, const int topY, renderAlign align, const int restrictWidth)
 {
-	int textW, textH;
-	SDL_Rect sourceRect;
-	SDL_Rect destinationRect;
-	SDL_QueryTexture(tex, NULL, NULL, &textW, &textH);
-
-	sourceRect.x = 0;
-	sourceRect.y = 0;
-	sourceRect.w = textW;
-	sourceRect.h = textH;
-
-	if (align == CENTRE)
-		destinationRect.x = x - (textW / 2);
-	else
-		destinationRect.x = x;
-	destinationRect.y = topY;
-	destinationRect.w = textW;
-	destinationRect.h = textH;
-
-	if (restrictWidth > 0)
-	{
-		if (textW > restrictWidth)
-			sourceRect.w = destinationRect.w = restrictWidth;
-	}
-	SDL_RenderCopy(g_window.screen_renderer, tex, &sourceRect, &destinationRect);
+	Font::drawString(l, x, topY, align == CENTRE ? Font::CENTRE : Font::LEFT, restrictWidth);
 }
 
 void PackEditor::renderNumbers(int num, const int rightX, const int y)
 {
-	int numChars[3];
-	int size = 0;
-	if (num == 0)
-	{
-		size = 1;
-		numChars[0] = 0;
-	}
-	else
-	{
-		while (num != 0)
-		{
-			//load number characters into array in reverse order
-			numChars[size] = num % 10;
-			num /= 10;
-			size++;
-		}
-	}
-
-	int textW, textH, drawX;
-	SDL_Rect textRect;
-	drawX = rightX;
-	for (int i = 0; i < size; i++)
-	{
-		SDL_QueryTexture(numbers[numChars[i]], NULL, NULL, &textW, &textH);
-		drawX -= textW;
-		textRect.x = drawX;
-		textRect.y = y;
-		textRect.w = textW;
-		textRect.h = textH;
-		SDL_RenderCopy(g_window.screen_renderer, numbers[numChars[i]], NULL, &textRect);
-	}
+	Font::drawString(20, std::to_string(num), rightX, y, Font::RIGHT);
 }
 
 void PackEditor::swapLevelPosition(int idFrom, int idTo, tribeName tribe)
@@ -1271,37 +1152,57 @@ void PackEditor::swapLevelPosition(int idFrom, int idTo, tribeName tribe)
 		return;
 	}
 
-	fs::path fromDatPath = l3_filename_level(packPath.parent_path(), "LEVEL", fullIdFrom, "DAT");
-	fs::path toDatPath = l3_filename_level(packPath.parent_path(), "LEVEL", fullIdTo, "DAT");
-	fs::path fromTempPath = l3_filename_level(packPath.parent_path(), "TEMP", fullIdFrom, "OBS");
-	fs::path toTempPath = l3_filename_level(packPath.parent_path(), "TEMP", fullIdTo, "OBS");
-	fs::path fromPermPath = l3_filename_level(packPath.parent_path(), "PERM", fullIdFrom, "OBS");
-	fs::path toPermPath = l3_filename_level(packPath.parent_path(), "PERM", fullIdTo, "OBS");
+	std::vector<int> order;
+	for (int i = 1; i <= (int)levels[tribe].size(); i++)
+		order.push_back(i);
+	std::swap(order[idFrom - 1], order[idTo - 1]);
 
-	fs::path temporaryPath = packPath.parent_path();
-	temporaryPath /= "temporary.temp";
+	rearrangeLevels(tribe, order);
+}
 
-	Mainmenu::updateOBSValues(fromDatPath, fullIdTo);
-	Mainmenu::updateOBSValues(toDatPath, fullIdFrom);
-	fs::rename(fromDatPath, temporaryPath);
-	fs::rename(toDatPath, fromDatPath);
-	fs::rename(temporaryPath, toDatPath);
+bool PackEditor::rearrangeLevels(const tribeName t, const std::vector<int> &order)
+{
+	const int count = levels[t].size();
+	std::vector<bool> kept(count + 1, false);
+	std::vector<levelData> arranged;
 
-	fs::rename(fromTempPath, temporaryPath);
-	fs::rename(toTempPath, fromTempPath);
-	fs::rename(temporaryPath, toTempPath);
+	//only levels whose number changes are moved, swaps and cycles go through temporary names
+	MoveTransaction moves(packPath.parent_path());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const int from = order[i];
+		if (from < 1 || from > count || kept[from])
+		{
+			SDL_Log("rearrangeLevels: Invalid level order\n");
+			return false;
+		}
+		kept[from] = true;
+		moves.moveLevel(from + (t * 100), (int)i + 1 + (t * 100));
+		arranged.push_back(levels[t][from - 1]);
+	}
+	for (int n = 1; n <= count; n++)
+		if (!kept[n])
+			moves.removeLevel(n + (t * 100));
 
-	fs::rename(fromPermPath, temporaryPath);
-	fs::rename(toPermPath, fromPermPath);
-	fs::rename(temporaryPath, toPermPath);
+	//the pack file is rewritten once, in the same batch as the level files
+	std::vector<levelData> previous = levels[t];
+	levels[t] = arranged;
+	const std::string listing = packListing();
+	moves.write(packPath, std::vector<Uint8>(listing.begin(), listing.end()));
 
-	fs::remove(temporaryPath);
+	if (!moves.commit())
+	{
+		levels[t] = previous;
+		tinyfd_messageBox("Oh No!", "Lem3edit could not move the level files for some reason!\n\nLevel reorganising aborted.", "ok", "error", 1);
+		return false;
+	}
 
-	if (idFrom < idTo)
-		std::swap(levels[tribe].at(idFrom - 1), levels[tribe].at(idTo - 1));
-	else
-		std::swap(levels[tribe].at(idTo - 1), levels[tribe].at(idFrom - 1));
+	for (int n = 1; n <= count; n++)
+		if (n > (int)order.size() || order[n - 1] != n)
+			index.forget(n + (t * 100));
+	index.save();
 
-	save();
+	refreshLemCounts();
 	redraw = true;
+	return true;
 }
@@ -21,7 +21,10 @@
 #ifndef PACKEDITOR_HPP
 #define PACKEDITOR_HPP
 
+#include "../font.hpp"
 #include "../lem3edit.hpp"
+#include "../packindex.hpp"
+#include "../watcher.hpp"
 
 #include "SDL.h"
 
@@ -49,6 +52,7 @@ public:
 	bool create(void);
 	bool load(const fs::path fileName);
 	bool save(void);
+	std::string packListing(void) const;
 
 private:
 	Ini * ini_ptr;
@@ -56,30 +60,37 @@ private:
 	Mainmenu * menu_ptr;
 
 	bool redraw = false;
+	//only the level list needs repainting, such as after scrolling
+	bool redrawList = false;
 
-	//stores a level ID to refresh the lemming count for that level on next draw. 0 = no level.
-	int refreshID = 0;
+	//notices levels changed by the editor or other programs, so only their lemming counts are refreshed
+	FileWatcher watcher;
+	void refreshChangedLevels(void);
 
 	Uint32 lastFrameTick = 0;
 
 	int scroll[TRIBECOUNT] = { 0, 0, 0 };
+	void scrollBy(const int rows);
+	//rows of the level list that fit in the window, and which of them is under a y position (-1 for none)
+	int visibleRows(void) const;
+	int rowAtY(const int y) const;
 	SDL_Rect scrollBarRect;
 
 	int version = CURRENTPACKFILEVERSION;
 
 	fs::path packPath;
+	PackIndex index;
 
 	tribeName tribeTab = CLASSIC;
 
-	SDL_Texture * numbers[10] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-	SDL_Texture * packTitleTex = NULL;
-	SDL_Texture * classicTabTex = NULL;
-	SDL_Texture * shadowTabTex = NULL;
-	SDL_Texture * egyptTabTex = NULL;
-	SDL_Texture * totalLemsTex = NULL;
-	SDL_Texture * quitTex = NULL;
-	SDL_Texture * addNewLevelTex = NULL;
-	SDL_Texture * loadLevelTex = NULL;
+	Font::Label packTitle;
+	Font::Label classicTab;
+	Font::Label shadowTab;
+	Font::Label egyptTab;
+	Font::Label totalLemsLabel;
+	Font::Label quitLabel;
+	Font::Label addNewLevelLabel;
+	Font::Label loadLevelLabel;
 
 	SDL_Texture * moveUpButtonTex = NULL;
 	SDL_Texture * moveDownButtonTex = NULL;
@@ -93,11 +104,8 @@ private:
 	public:
 		levelData(std::string s, int n);
 
-		void refreshTexture(void);
-
 		std::string name;
 		int lems;
-		SDL_Texture * tex = NULL;
 	};
 
 	void createLevel(const int n, const tribeName t);
@@ -106,7 +114,7 @@ private:
 	void deleteLevel(const int n, const tribeName t);
 
 	bool levelExists(const int id);//returns if level files exist and all match expected id
-	void refreshTitleTexture(void);
+	void refreshTitle(void);
 
 	std::vector<levelData> levels[TRIBECOUNT];
 	void clearLevels(void);
@@ -118,10 +126,12 @@ private:
 	void draw(void);
 	enum renderAlign { LEFT, CENTRE };
 	//Renders text, pass LEFT or CENTRE as alignment, pass 0 for no width restriction
-	void renderText(SDL_Texture * tex, const int x, const int topY, const renderAlign align, const int restrictWidth);
+	void renderText(const Font::Label &l, const int x, const int topY, const renderAlign align, const int restrictWidth);
 	void renderNumbers(int num, const int rightX, const int y);
 
 	void swapLevelPosition(int idFrom, int idTo, tribeName tribe);
+	//order lists current level numbers (from 1) in their new order, levels left out are deleted
+	bool rearrangeLevels(const tribeName t, const std::vector<int> &order);
 };
 
 #endif // PACKEDITOR_HPP
@@ -0,0 +1,379 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for packing a whole level pack into one archive file and reading levels back out of it
+ */
+
+#include "archive.hpp"
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+#include "transaction.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// "L3AR", version, level count, block count, listing offset, listing size
+#define HEADER_SIZE 24
+// id, DAT header, PERM block, TEMP block
+#define LEVEL_ENTRY_SIZE (4 + Level::DAT_SIZE + 8)
+// offset, size, flags, l3_hash of the contents
+#define BLOCK_ENTRY_SIZE 20
+#define VERSION 1
+
+// Blocks are only stored as they are for now, flags leaves room for a compressed form
+#define BLOCK_STORED 0
+
+static bool readWholeFile(const fs::path filename, vector<Uint8> &data)
+{
+	ifstream f(filename, ios::binary);
+	if (!f)
+	{
+		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+		return false;
+	}
+	data.assign(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+	return true;
+}
+
+bool PackArchive::exportPack(const fs::path source, const fs::path archivePath)
+{
+	LevelBatch batch;
+	if (!batch.find(source))
+		return false;
+
+	vector<Uint8> listing;
+	if (source.extension() == ".l3pack" && !readWholeFile(source, listing))
+		return false;
+
+	class LevelFiles
+	{
+	public:
+		vector<Uint8> header;
+		vector<Uint8> objects[2]; // PERM, TEMP
+		bool read;
+	};
+
+	// Read every level's files in parallel, following the TEMP and PERM ids in its header
+	vector<LevelFiles> levels(batch.items.size());
+	parallel_for(batch.items.size(), [&](int i)
+	{
+		const LevelBatch::Item &item = batch.items[i];
+		LevelFiles &l = levels[i];
+		l.read = readWholeFile(item.datPath, l.header) && l.header.size() >= (size_t)Level::DAT_SIZE &&
+			readWholeFile(l3_filename_level(batch.folder, "PERM", l3_read_le16(&l.header[8]), "OBS"), l.objects[PERM]) &&
+			readWholeFile(l3_filename_level(batch.folder, "TEMP", l3_read_le16(&l.header[6]), "OBS"), l.objects[TEMP]);
+		if (!l.read)
+			return;
+
+		// Unpacked levels always use their own id for both OBS files
+		l.header.resize(Level::DAT_SIZE);
+		l3_write_le16(&l.header[6], item.id);
+		l3_write_le16(&l.header[8], item.id);
+	});
+
+	vector<int> order;
+	for (unsigned int i = 0; i < levels.size(); ++i)
+	{
+		if (levels[i].read)
+			order.push_back(i);
+		else
+			SDL_Log("exportPack: Leaving out level %d, its files couldn't be read\n", batch.items[i].id);
+	}
+	sort(order.begin(), order.end(), [&](int a, int b) { return batch.items[a].id < batch.items[b].id; });
+
+	// Store each distinct OBS file once, levels using the same contents share a block
+	vector<const vector<Uint8> *> blocks;
+	vector<Uint64> blockHashes;
+	multimap<Uint64, Uint32> byHash;
+	vector< pair<Uint32, Uint32> > levelBlocks(levels.size());
+	size_t dataSize = 0;
+	for (vector<int>::const_iterator i = order.begin(); i != order.end(); ++i)
+	{
+		for (int type = PERM; type <= TEMP; ++type)
+		{
+			const vector<Uint8> &objects = levels[*i].objects[type];
+			const Uint64 h = l3_hash(objects.data(), objects.size());
+
+			Uint32 n = (Uint32)blocks.size();
+			for (multimap<Uint64, Uint32>::const_iterator same = byHash.lower_bound(h); same != byHash.end() && same->first == h; ++same)
+			{
+				if (*blocks[same->second] == objects)
+				{
+					n = same->second;
+					break;
+				}
+			}
+			if (n == blocks.size())
+			{
+				blocks.push_back(&objects);
+				blockHashes.push_back(h);
+				byHash.insert(make_pair(h, n));
+				dataSize += objects.size();
+			}
+			(type == PERM ? levelBlocks[*i].first : levelBlocks[*i].second) = n;
+		}
+	}
+
+	const size_t listingOffset = HEADER_SIZE + order.size() * LEVEL_ENTRY_SIZE + blocks.size() * BLOCK_ENTRY_SIZE;
+	size_t dataOffset = listingOffset + listing.size();
+
+	// Written under a temporary name then renamed, like the pack index
+	fs::path staged = archivePath;
+	staged += ".new";
+	{
+		MappedFile file;
+		if (!file.create(staged, dataOffset + dataSize))
+			return false;
+
+		Uint8 *p = file.writableData();
+		memcpy(p, "L3AR", 4);
+		l3_write_le32(p + 4, VERSION);
+		l3_write_le32(p + 8, (Uint32)order.size());
+		l3_write_le32(p + 12, (Uint32)blocks.size());
+		l3_write_le32(p + 16, (Uint32)listingOffset);
+		l3_write_le32(p + 20, (Uint32)listing.size());
+		p += HEADER_SIZE;
+
+		for (vector<int>::const_iterator i = order.begin(); i != order.end(); ++i, p += LEVEL_ENTRY_SIZE)
+		{
+			l3_write_le32(p, batch.items[*i].id);
+			memcpy(p + 4, levels[*i].header.data(), Level::DAT_SIZE);
+			l3_write_le32(p + 4 + Level::DAT_SIZE, levelBlocks[*i].first);
+			l3_write_le32(p + 8 + Level::DAT_SIZE, levelBlocks[*i].second);
+		}
+
+		for (unsigned int n = 0; n < blocks.size(); ++n, p += BLOCK_ENTRY_SIZE)
+		{
+			l3_write_le32(p, (Uint32)dataOffset);
+			l3_write_le32(p + 4, (Uint32)blocks[n]->size());
+			l3_write_le32(p + 8, BLOCK_STORED);
+			l3_write_le32(p + 12, (Uint32)(blockHashes[n] & 0xFFFFFFFF));
+			l3_write_le32(p + 16, (Uint32)(blockHashes[n] >> 32));
+			if (!blocks[n]->empty())
+				memcpy(file.writableData() + dataOffset, blocks[n]->data(), blocks[n]->size());
+			dataOffset += blocks[n]->size();
+		}
+
+		if (!listing.empty())
+			memcpy(p, listing.data(), listing.size());
+	}
+
+	error_code ec;
+	fs::rename(staged, archivePath, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to write '%s'\n", archivePath.generic_string().c_str());
+		fs::remove(staged, ec);
+		return false;
+	}
+
+	SDL_Log("Exported %d levels to '%s', %d of %d OBS files were stored\n", (int)order.size(), archivePath.generic_string().c_str(), (int)blocks.size(), (int)order.size() * 2);
+	return order.size() == levels.size();
+}
+
+bool PackArchive::importPack(const fs::path archivePath, const fs::path folder)
+{
+	PackArchive archive;
+	if (!archive.open(archivePath))
+		return false;
+
+	error_code ec;
+	fs::create_directories(folder, ec);
+	SaveTransaction::recover(folder);
+
+	// Never overwrite, the folder may already hold a different pack
+	vector<fs::path> targets;
+	const string listing = archive.packListing();
+	for (int i = 0; i < archive.levelCount(); ++i)
+	{
+		const int id = archive.levelId(i);
+		targets.push_back(l3_filename_level(folder, "LEVEL", id, "DAT"));
+		targets.push_back(l3_filename_level(folder, "PERM", id, "OBS"));
+		targets.push_back(l3_filename_level(folder, "TEMP", id, "OBS"));
+	}
+	fs::path packPath = folder / archivePath.stem();
+	packPath += ".l3pack";
+	if (!listing.empty())
+		targets.push_back(packPath);
+	for (vector<fs::path>::const_iterator i = targets.begin(); i != targets.end(); ++i)
+	{
+		if (fs::exists(*i, ec))
+		{
+			SDL_Log("importPack: '%s' already exists\n", i->generic_string().c_str());
+			return false;
+		}
+	}
+
+	SaveTransaction save(folder);
+	for (int i = 0; i < archive.levelCount(); ++i)
+	{
+		const int id = archive.levelId(i);
+		const Uint8 *header = archive.levelHeader(id);
+		if (!save.add(l3_filename_level(folder, "LEVEL", id, "DAT"), vector<Uint8>(header, header + Level::DAT_SIZE)))
+			return false;
+
+		for (int type = PERM; type <= TEMP; ++type)
+		{
+			size_t size;
+			const Uint8 *objects = archive.levelObjects(id, type, size);
+			if (objects == NULL || !save.add(l3_filename_level(folder, type == PERM ? "PERM" : "TEMP", id, "OBS"), vector<Uint8>(objects, objects + size)))
+				return false;
+		}
+	}
+	if (!listing.empty() && !save.add(packPath, vector<Uint8>(listing.begin(), listing.end())))
+		return false;
+
+	if (!save.commit())
+		return false;
+
+	SDL_Log("Imported %d levels into '%s'\n", archive.levelCount(), folder.generic_string().c_str());
+	return true;
+}
+
+bool PackArchive::open(const fs::path archivePath)
+{
+	path = archivePath;
+	if (!file.open(archivePath))
+		return false;
+
+	const Uint8 *p = file.data();
+	if (file.size() < HEADER_SIZE || memcmp(p, "L3AR", 4) != 0 || l3_read_le32(p + 4) != VERSION)
+	{
+		SDL_Log("'%s' is not a lem3edit pack archive\n", archivePath.generic_string().c_str());
+		file.close();
+		return false;
+	}
+
+	const Uint64 tables = HEADER_SIZE + (Uint64)l3_read_le32(p + 8) * LEVEL_ENTRY_SIZE + (Uint64)l3_read_le32(p + 12) * BLOCK_ENTRY_SIZE;
+	if (tables > file.size() || (Uint64)l3_read_le32(p + 16) + l3_read_le32(p + 20) > file.size())
+	{
+		SDL_Log("'%s' is cut short\n", archivePath.generic_string().c_str());
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+int PackArchive::levelCount(void) const
+{
+	return file.data() == NULL ? 0 : (int)l3_read_le32(file.data() + 8);
+}
+
+int PackArchive::levelId(int i) const
+{
+	return (int)l3_read_le32(file.data() + HEADER_SIZE + i * LEVEL_ENTRY_SIZE);
+}
+
+string PackArchive::packListing(void) const
+{
+	if (file.data() == NULL)
+		return string();
+	const Uint8 *p = file.data();
+	return string((const char *)p + l3_read_le32(p + 16), l3_read_le32(p + 20));
+}
+
+const Uint8 * PackArchive::findLevel(int id) const
+{
+	// The level table is sorted by id
+	int low = 0, high = levelCount();
+	while (low < high)
+	{
+		const int mid = (low + high) / 2;
+		const int midId = levelId(mid);
+		if (midId == id)
+			return file.data() + HEADER_SIZE + mid * LEVEL_ENTRY_SIZE;
+		if (midId < id)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return NULL;
+}
+
+const Uint8 * PackArchive::block(Uint32 n, size_t &size) const
+{
+	const Uint8 *p = file.data();
+	if (n >= l3_read_le32(p + 12))
+		return NULL;
+
+	const Uint8 *entry = p + HEADER_SIZE + levelCount() * LEVEL_ENTRY_SIZE + n * BLOCK_ENTRY_SIZE;
+	const Uint32 offset = l3_read_le32(entry);
+	size = l3_read_le32(entry + 4);
+	if (l3_read_le32(entry + 8) != BLOCK_STORED)
+	{
+		SDL_Log("'%s' uses a block format this version can't read\n", path.generic_string().c_str());
+		return NULL;
+	}
+	if ((Uint64)offset + size > file.size())
+		return NULL;
+	return p + offset;
+}
+
+const Uint8 * PackArchive::levelHeader(int id) const
+{
+	const Uint8 *entry = findLevel(id);
+	return entry == NULL ? NULL : entry + 4;
+}
+
+const Uint8 * PackArchive::levelObjects(int id, int type, size_t &size) const
+{
+	const Uint8 *entry = findLevel(id);
+	if (entry == NULL)
+		return NULL;
+	return block(l3_read_le32(entry + 4 + Level::DAT_SIZE + (type == PERM ? 0 : 4)), size);
+}
+
+bool PackArchive::loadLevel(int id, Level &level) const
+{
+	const Uint8 *header = levelHeader(id);
+	size_t permSize, tempSize;
+	const Uint8 *perm = levelObjects(id, PERM, permSize);
+	const Uint8 *temp = levelObjects(id, TEMP, tempSize);
+	if (header == NULL || perm == NULL || temp == NULL)
+	{
+		SDL_Log("Level %d is missing from '%s'\n", id, path.generic_string().c_str());
+		return false;
+	}
+
+	level.levelPath.clear();
+	level.level_id = id;
+	level.originX = level.originY = 0;
+	level.decode_level(header);
+
+	level.object[PERM].clear();
+	level.object[TEMP].clear();
+	level.object[TOOL].clear();
+	level.decode_objects(PERM, perm, permSize);
+	level.decode_objects(TEMP, temp, tempSize);
+	return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include "mappedfile.hpp"
+
+#include "SDL.h"
+
+#include <string>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Level;
+
+// A whole pack in one .l3arc file, for handing packs around without hundreds of loose files.
+// It starts with a table of levels sorted by id and a table of OBS blocks, each block stored
+// once however many levels use the same contents, so a level can be read straight out of the
+// mapped file without unpacking anything else.
+class PackArchive
+{
+public:
+	// Takes a .l3pack or a folder of LEVEL###.DAT files
+	static bool exportPack(const fs::path source, const fs::path archivePath);
+	// Unpacks into folder as loose files, with a .l3pack named after the archive if it came from one
+	static bool importPack(const fs::path archivePath, const fs::path folder);
+
+	bool open(const fs::path archivePath);
+	void close(void) { file.close(); }
+
+	int levelCount(void) const;
+	int levelId(int i) const;
+	bool hasLevel(int id) const { return findLevel(id) != NULL; }
+
+	// The .l3pack text the archive was made from, empty for a folder
+	std::string packListing(void) const;
+
+	// The DAT header, always naming id as its TEMP and PERM files
+	const Uint8 * levelHeader(int id) const;
+	// PERM or TEMP, NULL if the level isn't in the archive
+	const Uint8 * levelObjects(int id, int type, size_t &size) const;
+	// Fills level with the contents it would have loaded from the loose files. Nothing on disk
+	// backs it, so its levelPath is left empty and it can't be saved; import the archive to edit it.
+	bool loadLevel(int id, Level &level) const;
+
+private:
+	MappedFile file;
+	fs::path path;
+
+	const Uint8 * findLevel(int id) const;
+	const Uint8 * block(Uint32 n, size_t &size) const;
+};
+
+#endif // ARCHIVE_HPP
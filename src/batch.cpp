@@ -0,0 +1,276 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for loading a whole pack or folder of levels at once for the command line modes and the pack editor
+ */
+
+#include "archive.hpp"
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "pack.hpp"
+#include "parallel.hpp"
+#include "style.hpp"
+#include "transaction.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+LevelBatch::Item::Item(int id, bool inPack, tribeName tribe, const string &name, const fs::path &datPath)
+	: id(id), inPack(inPack), tribe(tribe), name(name), datPath(datPath), level(new Level()), loaded(false)
+{
+	/* nothing to do */
+}
+
+LevelBatch::LevelBatch(void) : version(0)
+{
+	/* nothing to do */
+}
+
+LevelBatch::~LevelBatch(void)
+{
+	/* nothing to do */
+}
+
+bool LevelBatch::find(const fs::path path)
+{
+	items.clear();
+	files.clear();
+	archive.reset();
+
+	if (path.extension() == ".l3arc")
+		return listArchive(path);
+
+	if (path.extension() == ".l3pack")
+	{
+		// An interrupted save or renumbering may have the pack file itself set aside
+		folder = path.parent_path();
+		SaveTransaction::recover(folder);
+
+		vector<Pack::Entry> entries;
+		if (!Pack::readEntries(path, entries, version))
+			return false;
+
+		if (!listFolder())
+			return false;
+
+		for (vector<Pack::Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i)
+			items.emplace_back(Item(i->id, true, i->tribe, i->name, l3_filename_level(folder, "LEVEL", i->id, "DAT")));
+
+		return true;
+	}
+
+	folder = path;
+	SaveTransaction::recover(folder);
+	if (!listFolder())
+		return false;
+
+	for (map<string, File>::const_iterator i = files.begin(); i != files.end(); ++i)
+	{
+		// only take files named LEVEL###.DAT
+		const string &name = i->first;
+		if (name.size() != 12 || name.compare(0, 5, "LEVEL") != 0 || name.compare(8, 4, ".DAT") != 0)
+			continue;
+		if (!isdigit(name[5]) || !isdigit(name[6]) || !isdigit(name[7]))
+			continue;
+
+		int id = atoi(name.substr(5, 3).c_str());
+		items.emplace_back(Item(id, false, CLASSIC, name, folder / name));
+	}
+
+	return true;
+}
+
+bool LevelBatch::listFolder(void)
+{
+	error_code ec;
+	fs::directory_iterator iter(folder, ec);
+	if (ec)
+	{
+		SDL_Log("LevelBatch: Couldn't read folder '%s'\n", folder.generic_string().c_str());
+		return false;
+	}
+
+	for (; iter != fs::directory_iterator(); iter.increment(ec))
+	{
+		if (ec)
+			break;
+
+		File f;
+		f.size = fs::file_size(iter->path(), ec);
+		if (ec)
+		{
+			ec.clear();
+			continue; // not a regular file
+		}
+		f.time = fs::last_write_time(iter->path(), ec).time_since_epoch().count();
+		ec.clear();
+		files[iter->path().filename().generic_string()] = f;
+	}
+	return true;
+}
+
+bool LevelBatch::listArchive(const fs::path path)
+{
+	archive.reset(new PackArchive());
+	if (!archive->open(path))
+		return false;
+	folder = path.parent_path();
+
+	// Stand in for the folder listing, so the archive looks like the files it was made from
+	for (int i = 0; i < archive->levelCount(); ++i)
+	{
+		const int id = archive->levelId(i);
+		files[l3_filename_level("", "LEVEL", id, "DAT").generic_string()] = { (uintmax_t)Level::DAT_SIZE, 0 };
+		for (int type = PERM; type <= TEMP; ++type)
+		{
+			size_t size;
+			if (archive->levelObjects(id, type, size) != NULL)
+				files[l3_filename_level("", type == PERM ? "PERM" : "TEMP", id, "OBS").generic_string()] = { (uintmax_t)size, 0 };
+		}
+	}
+
+	vector<Pack::Entry> entries;
+	istringstream listing(archive->packListing());
+	if (!listing.str().empty() && Pack::readEntries(listing, entries, version))
+	{
+		for (vector<Pack::Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i)
+			items.emplace_back(Item(i->id, true, i->tribe, i->name, l3_filename_level(path, "LEVEL", i->id, "DAT")));
+		return true;
+	}
+
+	for (int i = 0; i < archive->levelCount(); ++i)
+	{
+		const int id = archive->levelId(i);
+		const fs::path datPath = l3_filename_level(path, "LEVEL", id, "DAT");
+		items.emplace_back(Item(id, false, CLASSIC, datPath.filename().generic_string(), datPath));
+	}
+	return true;
+}
+
+bool LevelBatch::fileExists(const string &prefix, int n, const string &ext) const
+{
+	return files.find(l3_filename_level("", prefix, n, ext).generic_string()) != files.end();
+}
+
+uintmax_t LevelBatch::fileSize(const string &prefix, int n, const string &ext) const
+{
+	const File *f = file(prefix, n, ext);
+	return f == NULL ? 0 : f->size;
+}
+
+const LevelBatch::File * LevelBatch::file(const string &prefix, int n, const string &ext) const
+{
+	map<string, File>::const_iterator i = files.find(l3_filename_level("", prefix, n, ext).generic_string());
+	if (i == files.end())
+		return NULL;
+	return &i->second;
+}
+
+bool LevelBatch::hasLevelFiles(int id) const
+{
+	return fileExists("LEVEL", id, "DAT") && fileExists("TEMP", id, "OBS") && fileExists("PERM", id, "OBS");
+}
+
+void LevelBatch::loadHeaders(void)
+{
+	parallel_for(items.size(), [&](int i)
+	{
+		Item &item = items[i];
+		if (!item.header.empty() || fileSize("LEVEL", item.id, "DAT") < Level::DAT_SIZE)
+			return;
+
+		if (archive)
+		{
+			const Uint8 *header = archive->levelHeader(item.id);
+			item.header.assign(header, header + Level::DAT_SIZE);
+			return;
+		}
+
+		ifstream f(item.datPath, ios::binary);
+		vector<Uint8> buffer(Level::DAT_SIZE);
+		if (f && f.read((char *)buffer.data(), buffer.size()))
+			item.header.swap(buffer);
+	});
+}
+
+void LevelBatch::loadLevels(void)
+{
+	parallel_for(items.size(), [&](int i)
+	{
+		Item &item = items[i];
+		if (archive)
+			item.loaded = archive->loadLevel(item.id, *item.level);
+		else
+			item.loaded = fileExists("LEVEL", item.id, "DAT") && item.level->load(item.datPath);
+	});
+}
+
+void LevelBatch::loadStyles(const fs::path dataPath)
+{
+	// Levels share styles, so only decode each of them once
+	for (vector<Item>::const_iterator i = items.begin(); i != items.end(); ++i)
+	{
+		if (i->loaded && styles.find(i->level->style) == styles.end())
+			styles[i->level->style].reset(new Style());
+	}
+
+	vector< pair<int, Style *> > toLoad;
+	for (map< int, unique_ptr<Style> >::iterator i = styles.begin(); i != styles.end(); ++i)
+		toLoad.push_back(make_pair(i->first, i->second.get()));
+
+	vector<char> loaded(toLoad.size(), false);
+	parallel_for(toLoad.size(), [&](int i)
+	{
+		loaded[i] = toLoad[i].second->load_data(toLoad[i].first, dataPath);
+	});
+
+	for (unsigned int i = 0; i < toLoad.size(); ++i)
+	{
+		if (!loaded[i])
+			styles.erase(toLoad[i].first);
+	}
+
+	for (vector<Item>::iterator i = items.begin(); i != items.end(); ++i)
+	{
+		if (!i->loaded)
+			continue;
+		map< int, unique_ptr<Style> >::iterator style = styles.find(i->level->style);
+		if (style != styles.end())
+			i->level->setReferences(NULL, style->second.get());
+	}
+}
+
+const Style * LevelBatch::style(int n) const
+{
+	map< int, unique_ptr<Style> >::const_iterator i = styles.find(n);
+	if (i == styles.end())
+		return NULL;
+	return i->second.get();
+}
@@ -0,0 +1,106 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "lem3edit.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Level;
+class PackArchive;
+class Style;
+
+// A set of levels from a pack or folder, loaded together for the command line modes and the pack editor
+class LevelBatch
+{
+public:
+	class Item
+	{
+	public:
+		int id;
+		bool inPack;
+		tribeName tribe; // only known for levels in a pack
+		std::string name;
+		fs::path datPath;
+
+		std::unique_ptr<Level> level;
+		bool loaded;
+
+		// the raw DAT header, filled by loadHeaders, empty if it couldn't be read
+		std::vector<Uint8> header;
+
+		Item(int id, bool inPack, tribeName tribe, const std::string &name, const fs::path &datPath);
+	};
+
+	fs::path folder;
+	std::vector<Item> items;
+	int version; // from the .l3pack, if one was found
+
+	class File
+	{
+	public:
+		uintmax_t size;
+		Sint64 time; // last write time, only compared for equality
+	};
+
+	// file name -> size and time, from a single listing of the folder or from the archive's tables
+	std::map<std::string, File> files;
+
+	// set when the levels come from a .l3arc instead of loose files
+	std::unique_ptr<PackArchive> archive;
+
+	std::map< int, std::unique_ptr<Style> > styles;
+
+	// Pass a .l3pack file, a .l3arc archive or a folder holding LEVEL###.DAT files
+	bool find(const fs::path path);
+	bool fileExists(const std::string &prefix, int n, const std::string &ext) const;
+	uintmax_t fileSize(const std::string &prefix, int n, const std::string &ext) const;
+	const File * file(const std::string &prefix, int n, const std::string &ext) const;
+	// LEVEL, PERM and TEMP files all present for the id
+	bool hasLevelFiles(int id) const;
+
+	// Reads just the DAT header of every level without one yet in parallel, for when the objects aren't needed
+	void loadHeaders(void);
+
+	// Loads every level in parallel, then every style those levels use, once each
+	void loadLevels(void);
+	void loadStyles(const fs::path dataPath);
+
+	const Style * style(int n) const;
+
+	LevelBatch(void);
+	~LevelBatch(void);
+
+private:
+	LevelBatch(const LevelBatch &);
+	LevelBatch & operator=(const LevelBatch &);
+
+	bool listFolder(void);
+	bool listArchive(const fs::path path);
+};
+
+#endif // BATCH_HPP
@@ -29,15 +29,176 @@ This file contains code for printing text to the screen, using SDL_ttf
 #include "SDL.h"
 #include "SDL_ttf.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace std;
 
-SDL_Texture * Font::createTextureFromString(TTF_Font * f, std::string s)
+map<int, Font::Atlas> Font::atlases;
+
+TTF_Font * Font::get(const int size)
+{
+	Atlas &a = atlases[size];
+	if (a.font == NULL)
+	{
+		a.font = TTF_OpenFont("./gfx/DejaVuSansMono.ttf", size);
+		if (a.font == NULL)
+			SDL_Log("Font::get: Unable to open font at size %d! TTF Error: %s\n", size, TTF_GetError());
+	}
+	return a.font;
+}
+
+void Font::closeAll(void)
+{
+	for (map<int, Atlas>::iterator i = atlases.begin(); i != atlases.end(); ++i)
+	{
+		if (i->second.texture != NULL)
+			SDL_DestroyTexture(i->second.texture);
+		if (i->second.font != NULL)
+			TTF_CloseFont(i->second.font);
+	}
+	atlases.clear();
+}
+
+Font::Atlas * Font::atlas(const int size)
+{
+	if (get(size) == NULL)
+		return NULL;
+
+	Atlas &a = atlases[size];
+	if (a.texture == NULL && !buildAtlas(a))
+		return NULL;
+	return &a;
+}
+
+// rasterises every glyph once and packs them into a single texture, a fixed cell per glyph
+bool Font::buildAtlas(Atlas &a)
+{
+	SDL_Color c = { 0, 0, 0, 255 };
+	SDL_Surface * glyphs[GLYPH_COUNT];
+	int cellW = 0, cellH = 0;
+
+	for (int i = 0; i < GLYPH_COUNT; i++)
+	{
+		glyphs[i] = TTF_RenderGlyph_Blended(a.font, (Uint16)(FIRST_GLYPH + i), c);
+		a.advance[i] = 0;
+		if (glyphs[i] == NULL)
+			continue;
+		if (glyphs[i]->format->format != SDL_PIXELFORMAT_ARGB8888)
+		{
+			SDL_Surface * converted = SDL_ConvertSurfaceFormat(glyphs[i], SDL_PIXELFORMAT_ARGB8888, 0);
+			SDL_FreeSurface(glyphs[i]);
+			glyphs[i] = converted;
+			if (glyphs[i] == NULL)
+				continue;
+		}
+		if (TTF_GlyphMetrics(a.font, (Uint16)(FIRST_GLYPH + i), NULL, NULL, NULL, NULL, &a.advance[i]) != 0)
+			a.advance[i] = glyphs[i]->w;
+		cellW = std::max(cellW, glyphs[i]->w);
+		cellH = std::max(cellH, glyphs[i]->h);
+	}
+
+	a.height = TTF_FontHeight(a.font);
+	const int columns = 16;
+	const int rows = (GLYPH_COUNT + columns - 1) / columns;
+	if (cellW > 0 && cellH > 0)
+		a.texture = SDL_CreateTexture(g_window.screen_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, cellW * columns, cellH * rows);
+
+	if (a.texture == NULL)
+	{
+		SDL_Log("Font::buildAtlas: Unable to create glyph atlas! SDL Error: %s\n", SDL_GetError());
+		for (int i = 0; i < GLYPH_COUNT; i++)
+		{
+			if (glyphs[i] != NULL)
+				SDL_FreeSurface(glyphs[i]);
+		}
+		return false;
+	}
+
+	//start fully transparent so the gaps between glyphs never show
+	vector<Uint32> clear(cellW * columns * cellH * rows, 0);
+	SDL_UpdateTexture(a.texture, NULL, clear.data(), cellW * columns * sizeof(Uint32));
+	SDL_SetTextureBlendMode(a.texture, SDL_BLENDMODE_BLEND);
+
+	for (int i = 0; i < GLYPH_COUNT; i++)
+	{
+		SDL_Rect &r = a.glyph[i];
+		r.x = (i % columns) * cellW;
+		r.y = (i / columns) * cellH;
+		r.w = r.h = 0;
+		if (glyphs[i] == NULL)
+			continue;
+
+		r.w = glyphs[i]->w;
+		r.h = glyphs[i]->h;
+		SDL_UpdateTexture(a.texture, &r, glyphs[i]->pixels, glyphs[i]->pitch);
+		SDL_FreeSurface(glyphs[i]);
+	}
+
+	return true;
+}
+
+int Font::glyphIndex(const Atlas &a, const char c)
+{
+	int i = (unsigned char)c - FIRST_GLYPH;
+	if (i < 0 || a.glyph[i].w == 0)
+		i = '?' - FIRST_GLYPH;
+	return i;
+}
+
+int Font::stringWidth(const int size, const std::string &s)
+{
+	Atlas * a = atlas(size);
+	if (a == NULL)
+		return 0;
+
+	int w = 0;
+	for (size_t i = 0; i < s.length(); i++)
+		w += a->advance[glyphIndex(*a, s[i])];
+	return w;
+}
+
+int Font::lineHeight(const int size)
+{
+	Atlas * a = atlas(size);
+	return a == NULL ? 0 : a->height;
+}
+
+void Font::drawString(const int size, const std::string &s, const int x, const int topY, const Align align, const int restrictWidth)
+{
+	Atlas * a = atlas(size);
+	if (a == NULL)
+		return;
+
+	int drawX = x;
+	if (align == CENTRE)
+		drawX -= stringWidth(size, s) / 2;
+	else if (align == RIGHT)
+		drawX -= stringWidth(size, s);
+	const int startX = drawX;
+
+	for (size_t i = 0; i < s.length(); i++)
+	{
+		const int g = glyphIndex(*a, s[i]);
+		SDL_Rect sourceRect = a->glyph[g];
+		SDL_Rect destinationRect = { drawX, topY, sourceRect.w, sourceRect.h };
+
+		if (restrictWidth > 0)
+		{
+			const int remaining = restrictWidth - (drawX - startX);
+			if (remaining <= 0)
+				break;
+			if (sourceRect.w > remaining)
+				sourceRect.w = destinationRect.w = remaining;
+		}
+
+		SDL_RenderCopy(g_window.screen_renderer, a->texture, &sourceRect, &destinationRect);
+		drawX += a->advance[g];
+	}
+}
+
+void Font::drawString(const Label &l, const int x, const int topY, const Align align, const int restrictWidth)
 {
-	SDL_Color c = { 0, 0, 0 };
-	SDL_Surface * tempSurface = TTF_RenderText_Blended(f, s.c_str(), c);
-	SDL_Texture * t = SDL_CreateTextureFromSurface(g_window.screen_renderer, tempSurface);
-	SDL_FreeSurface(tempSurface);
-	return t;
+	drawString(l.size, l.text, x, topY, align, restrictWidth);
 }
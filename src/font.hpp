@@ -24,13 +24,55 @@
 #include "SDL.h"
 #include "SDL_ttf.h"
 
+#include <map>
 #include <string>
 
 class Font
 {
 public:
 
-	static SDL_Texture * createTextureFromString(TTF_Font * f, std::string s);
+	enum Align { LEFT, CENTRE, RIGHT };
+
+	// a fixed string and the size it is drawn at, in place of a pre-rendered texture
+	struct Label
+	{
+		Label(void) : size(0) { /* nothing to do */ }
+		Label(const int sz, const std::string &s) : size(sz), text(s) { /* nothing to do */ }
+
+		int size;
+		std::string text;
+	};
+
+	// each size of the editor font is opened once and shared until closeAll
+	static TTF_Font * get(const int size);
+	static void closeAll(void);
+
+	// draws from the glyph atlas for that size, pass 0 for no width restriction
+	static void drawString(const int size, const std::string &s, const int x, const int topY, const Align align, const int restrictWidth = 0);
+	static void drawString(const Label &l, const int x, const int topY, const Align align, const int restrictWidth = 0);
+	static int stringWidth(const int size, const std::string &s);
+	static int lineHeight(const int size);
+
+private:
+
+	// Latin-1 glyphs from space upwards, the same range TTF_RenderText covers
+	static const int FIRST_GLYPH = 32;
+	static const int GLYPH_COUNT = 256 - FIRST_GLYPH;
+
+	struct Atlas
+	{
+		TTF_Font * font = NULL;
+		SDL_Texture * texture = NULL;
+		SDL_Rect glyph[GLYPH_COUNT];
+		int advance[GLYPH_COUNT];
+		int height = 0;
+	};
+
+	static std::map<int, Atlas> atlases;
+
+	static Atlas * atlas(const int size);
+	static bool buildAtlas(Atlas &a);
+	static int glyphIndex(const Atlas &a, const char c);
 };
 
 #endif // FONT_HPP
@@ -24,12 +24,17 @@ This file contains code for reading from and writing to the ini file
 
 #include "ini.hpp"
 #include "lem3edit.hpp"
+#include "parallel.hpp"
 
 #include "SDL.h"
 
 #include <experimental/filesystem>
 #include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace fs = std::experimental::filesystem::v1;
 
@@ -38,6 +43,7 @@ bool Ini::load(void)
 	//set defaults
 	lem3cdPath = "";
 	lastLoadedPack = "";
+	undoMemoryKB = 4096;
 
 	fs::path iniPath = fs::current_path();
 	iniPath /= "lem3edit.ini";
@@ -62,6 +68,8 @@ bool Ini::load(void)
 						lem3cdPath = value;
 					if (key == "LASTPACK")
 						lastLoadedPack = value;
+					if (key == "UNDOMEMORY" && atoi(value.c_str()) > 0)
+						undoMemoryKB = atoi(value.c_str());
 				}
 			}
 
@@ -81,110 +89,197 @@ bool Ini::load(void)
 	return true;
 }
 
+//every data file the program might need, relative to the folder holding L3CD.EXE
+std::vector<fs::path> Ini::requiredFiles(void)
+{
+	std::vector<fs::path> files;
+	files.push_back("L3CD.EXE");
+
+	const int tribes[3] = { 4, 5, 10 };
+	const char *tribeFiles[5][2] = { { "TRIBE", "PAL" }, { "TRIBE", "IND" }, { "TRIBE", "CMP" }, { "TPANL", "DIN" }, { "TPANL", "DEL" } };
+	for (int i = 0; i < 5; i++)
+		for (int t = 0; t < 3; t++)
+			files.push_back(l3_filename_data("", "GRAPHICS", tribeFiles[i][0], tribes[t], tribeFiles[i][1]));
+
+	const char *styleFiles[9][2] = {
+		{ "DATA", "PAL" },
+		{ "PERM", "OBJ" }, { "PERM", "BLK" }, { "PERM", "FRL" },
+		{ "TEMP", "OBJ" }, { "TEMP", "BLK" }, { "TEMP", "FRL" },
+		{ "OBJEC", "CMP" }, { "OBJEC", "IND" } };
+	for (int i = 0; i < 9; i++)
+		for (int style = 1; style <= 3; style++)
+			files.push_back(l3_filename_data("", "STYLES", styleFiles[i][0], style, styleFiles[i][1]));
+
+	return files;
+}
+
+//finds every required file with one listing per folder rather than a stat each, returns if they are all there
+bool Ini::listDataFiles(const fs::path parentPath, std::vector<DataFile> &files)
+{
+	//names must match exactly, as the loaders open the files by these names. Only the names
+	//are read, so the listing costs nothing per file however much else the folders hold
+	std::set<std::string> listed;
+	std::set<fs::path> folders;
+	const std::vector<fs::path> required = requiredFiles();
+	for (std::vector<fs::path>::const_iterator i = required.begin(); i != required.end(); ++i)
+		folders.insert(i->parent_path());
+
+	for (std::set<fs::path>::const_iterator folder = folders.begin(); folder != folders.end(); ++folder)
+	{
+		std::error_code ec;
+		for (fs::directory_iterator i(parentPath / *folder, ec); !ec && i != fs::directory_iterator(); i.increment(ec))
+			listed.insert((*folder / i->path().filename()).generic_string());
+	}
+
+	bool success = true;
+	files.clear();
+	for (std::vector<fs::path>::const_iterator i = required.begin(); i != required.end(); ++i)
+	{
+		if (listed.find(i->generic_string()) == listed.end())
+		{
+			SDL_Log("validateData: '%s' is missing\n", (parentPath / *i).generic_string().c_str());
+			success = false;
+			continue;
+		}
+		files.push_back({ *i, 0, 0 });
+	}
+	return success;
+}
+
+//also fills in the sizes, counted while reading so the listing needn't stat anything
+void Ini::hashDataFiles(const fs::path parentPath, std::vector<DataFile> &files)
+{
+	parallel_for(files.size(), [&](int i)
+	{
+		std::ifstream f(parentPath / files[i].relative, std::ios::binary);
+		Uint8 buffer[65536];
+		Uint64 hash = l3_hash(NULL, 0);
+		uintmax_t size = 0;
+		while (f.read((char *)buffer, sizeof(buffer)) || f.gcount() > 0)
+		{
+			hash = l3_hash(buffer, (size_t)f.gcount(), hash);
+			size += f.gcount();
+		}
+		files[i].hash = hash;
+		files[i].size = size;
+	});
+}
+
+fs::path Ini::manifestPath(void)
+{
+	return fs::current_path() / "lem3edit.manifest";
+}
+
+//the manifest only counts if it was made for the same CD location
+bool Ini::loadManifest(const fs::path parentPath, std::vector<DataFile> &files)
+{
+	files.clear();
+	std::ifstream manifest(manifestPath());
+	std::string line;
+	if (!manifest.is_open() || !getline(manifest, line) || line != "CD=" + parentPath.generic_string())
+		return false;
+
+	while (getline(manifest, line))
+	{
+		std::istringstream fields(line);
+		std::string name;
+		DataFile file;
+		if (getline(fields, name, '\t') && fields >> file.size >> std::hex >> file.hash)
+		{
+			file.relative = name;
+			files.push_back(file);
+		}
+	}
+	return !files.empty();
+}
+
+bool Ini::saveManifest(const fs::path parentPath, const std::vector<DataFile> &files)
+{
+	std::ofstream manifest(manifestPath(), std::ios::trunc);
+	if (!manifest.is_open())
+	{
+		SDL_Log("Failed to save data manifest.");
+		return false;
+	}
+
+	manifest << "CD=" << parentPath.generic_string() << "\n";
+	for (std::vector<DataFile>::const_iterator i = files.begin(); i != files.end(); ++i)
+		manifest << i->relative.generic_string() << "\t" << i->size << "\t" << std::hex << std::setw(16) << std::setfill('0') << i->hash << std::dec << "\n";
+	return true;
+}
+
 bool Ini::validateData(void) {
-	return validateData(lem3cdPath.parent_path());
+	const fs::path parentPath = lem3cdPath.parent_path();
+	std::vector<DataFile> found;
+	if (!listDataFiles(parentPath, found))
+		return false;
+
+	std::vector<DataFile> recorded;
+	if (!loadManifest(parentPath, recorded))
+	{
+		//made by an older version or for another CD location, so record what is there now
+		hashDataFiles(parentPath, found);
+		saveManifest(parentPath, found);
+		return true;
+	}
+
+	//the names are all a launch checks; --verify-data looks at the contents
+	std::set<std::string> names;
+	for (std::vector<DataFile>::const_iterator i = recorded.begin(); i != recorded.end(); ++i)
+		names.insert(i->relative.generic_string());
+
+	//everything needed is there, so a file the manifest doesn't know is only noted and recorded
+	bool changed = false;
+	for (std::vector<DataFile>::const_iterator i = found.begin(); i != found.end(); ++i)
+	{
+		if (names.find(i->relative.generic_string()) == names.end())
+		{
+			SDL_Log("validateData: '%s' isn't in the manifest, updating it\n", (parentPath / i->relative).generic_string().c_str());
+			changed = true;
+		}
+	}
+	if (changed)
+	{
+		hashDataFiles(parentPath, found);
+		saveManifest(parentPath, found);
+	}
+	return true;
 }
 
-//check that every data file the program might need exists and return if successful
 bool Ini::validateData(const fs::path parentPath) {
-	bool success = true;
+	std::vector<DataFile> found;
+	if (!listDataFiles(parentPath, found))
+		return false;
 
-	fs::path l3cdPath = parentPath;
-	l3cdPath /= "L3CD.EXE";
-	if (!fs::exists(l3cdPath))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 4, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 5, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 10, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 4, "IND")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 5, "IND")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 10, "IND")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 4, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 5, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TRIBE", 10, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 4, "DIN")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 5, "DIN")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 10, "DIN")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 4, "DEL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 5, "DEL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "GRAPHICS", "TPANL", 10, "DEL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 1, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 2, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 3, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 1, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 2, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "DATA", 3, "PAL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 1, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 2, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 3, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 1, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 2, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 3, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 1, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 2, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "PERM", 3, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 1, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 2, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 3, "OBJ")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 1, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 2, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 3, "BLK")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 1, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 2, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "TEMP", 3, "FRL")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 1, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 2, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 3, "CMP")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 1, "IND")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 2, "IND")))
-		success = false;
-	if (!fs::exists(l3_filename_data(parentPath, "STYLES", "OBJEC", 3, "IND")))
-		success = false;
+	hashDataFiles(parentPath, found);
+	saveManifest(parentPath, found);
+	return true;
+}
 
-	return success;
+bool Ini::verifyData(void)
+{
+	const fs::path parentPath = lem3cdPath.parent_path();
+	std::vector<DataFile> recorded;
+	if (!loadManifest(parentPath, recorded))
+	{
+		SDL_Log("verifyData: There is no data manifest for '%s' yet\n", parentPath.generic_string().c_str());
+		return false;
+	}
+
+	std::vector<DataFile> found = recorded;
+	hashDataFiles(parentPath, found);
+
+	int changed = 0;
+	for (unsigned int i = 0; i < found.size(); i++)
+	{
+		if (found[i].hash != recorded[i].hash || found[i].size != recorded[i].size)
+		{
+			SDL_Log("verifyData: '%s' doesn't match the manifest\n", (parentPath / found[i].relative).generic_string().c_str());
+			changed++;
+		}
+	}
+	SDL_Log("Verified %d data files, %d changed\n", (int)found.size(), changed);
+	return changed == 0;
 }
 
 void Ini::saveLem3cdPath(fs::path p) {
@@ -207,6 +302,7 @@ bool Ini::save(void)
 	{
 		iniFile << "CD=" << lem3cdPath.generic_string() << "\n";
 		iniFile << "LASTPACK=" << lastLoadedPack.generic_string() << "\n";
+		iniFile << "UNDOMEMORY=" << undoMemoryKB << "\n";
 		iniFile.close();
 	}
 	else
@@ -20,7 +20,10 @@
 #ifndef INI_HPP
 #define INI_HPP
 
+#include "SDL.h"
+
 #include <string>
+#include <vector>
 #include <experimental/filesystem>
 
 namespace fs = std::experimental::filesystem::v1;
@@ -30,11 +33,16 @@ class Ini
 public:
 	fs::path lem3cdPath;
 	fs::path lastLoadedPack;
+	int undoMemoryKB; // how much memory the editor's undo history may use
 
 	bool load(void);
 
+	// Checks the data files are all there, listing each folder once and reading no file
 	bool validateData(void);
+	// For first time setup, checks the files are there and records the manifest
 	bool validateData(const fs::path parentPath);
+	// Hashes every data file and compares it with the manifest
+	bool verifyData(void);
 
 	void saveLem3cdPath(fs::path p);
 	void saveLastLoadedPack(fs::path p);
@@ -42,6 +50,21 @@ public:
 private:
 
 	bool save(void);
+
+	class DataFile
+	{
+	public:
+		fs::path relative; // from the folder holding L3CD.EXE
+		uintmax_t size;
+		Uint64 hash;
+	};
+
+	static std::vector<fs::path> requiredFiles(void);
+	static bool listDataFiles(const fs::path parentPath, std::vector<DataFile> &files);
+	static void hashDataFiles(const fs::path parentPath, std::vector<DataFile> &files);
+	static fs::path manifestPath(void);
+	static bool loadManifest(const fs::path parentPath, std::vector<DataFile> &files);
+	static bool saveManifest(const fs::path parentPath, const std::vector<DataFile> &files);
 };
 
 #endif // INI_HPP
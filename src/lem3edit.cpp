@@ -25,17 +25,24 @@
 
 #include "Editor/editor.hpp"
 #include "Main Menu/mainmenu.hpp"
+#include "archive.hpp"
 #include "font.hpp"
 #include "ini.hpp"
 #include "level.hpp"
 #include "raw.hpp"
+#include "render.hpp"
+#include "stats.hpp"
 #include "style.hpp"
 #include "tinyfiledialogs.h"
+#include "trace.hpp"
+#include "transaction.hpp"
 #include "tribe.hpp"
+#include "validate.hpp"
 #include "window.hpp"
 
 #include "SDL.h"
 
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -48,6 +55,8 @@ const char *prog_ver = "2.1";
 const char *prog_date = "05/05/2018";
 
 void version(void);
+int commandLine(int argc, char *argv[]);
+void usage(void);
 
 programMode g_currentMode;
 
@@ -57,18 +66,44 @@ int main(int argc, char *argv[])
 {
 	version();
 
+	// --startup-trace opens the editor as normal, so it is handled here rather than in commandLine
+	fs::path traceOutput = "startup-trace.json";
+	double startupBudgetMs = 0;
+	if (argc > 1 && string(argv[1]) == "--startup-trace")
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			string arg = argv[i];
+			if (arg == "--out" && i + 1 < argc)
+				traceOutput = argv[++i];
+			else if (arg == "--budget" && i + 1 < argc && atof(argv[i + 1]) > 0)
+				startupBudgetMs = atof(argv[++i]);
+			else
+			{
+				usage();
+				return EXIT_FAILURE;
+			}
+		}
+		StartupTrace::start();
+	}
+	else if (argc > 1)
+		return commandLine(argc, argv);
+
+	StartupTrace::phase("SDL_Init");
 	if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO))
 	{
 		SDL_Log("failed to initialize SDL: %s\n", SDL_GetError());
 		return EXIT_FAILURE;
 	}
 
+	StartupTrace::phase("TTF_Init");
 	if (TTF_Init() == -1)
 	{
 		SDL_Log("failed to initialize SDL_ttf: %s\n", TTF_GetError());
 		return EXIT_FAILURE;
 	}
 
+	StartupTrace::phase("Window::initialise");
 	if (g_window.initialise(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT) == false) // Initialise the main program window
 	{
 		return EXIT_FAILURE;
@@ -88,6 +123,7 @@ int main(int argc, char *argv[])
 	}
 
 	//load ini file
+	StartupTrace::phase("Ini::load");
 	Ini ini;
 
 	if (!ini.load())
@@ -132,6 +168,7 @@ int main(int argc, char *argv[])
 	}
 	else
 	{
+		StartupTrace::phase("Ini::validateData");
 		if (!ini.validateData())
 		{
 			tinyfd_messageBox(
@@ -144,13 +181,28 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	// Finish or undo any save that was interrupted last time. The pack file itself may
+	// be the one set aside, so only its folder has to exist.
+	StartupTrace::phase("SaveTransaction::recover");
+	if (!ini.lastLoadedPack.empty() && fs::exists(ini.lastLoadedPack.parent_path()))
+		SaveTransaction::recover(ini.lastLoadedPack.parent_path());
+
 	g_currentMode = MAINMENUMODE;
 
+	StartupTrace::phase("Editor");
 	Editor editor(ini.lem3cdPath.parent_path());
-	Mainmenu mainmenu(&ini, &editor);
+	editor.history.setMemoryBudget((size_t)ini.undoMemoryKB * 1024);
+	StartupTrace::phase("Mainmenu");
+	Mainmenu mainmenu(&ini, &editor); // ends with the first frame
+
+	// With a budget this is a timing check, so quit as soon as the menu is up
+	bool startupOk = true;
+	if (StartupTrace::enabled())
+		startupOk = StartupTrace::report(traceOutput, startupBudgetMs);
+	const bool quitAfterStartup = startupBudgetMs > 0;
 
 	SDL_Event event;
-	while (SDL_WaitEvent(&event) && event.type != SDL_QUIT)
+	while (!quitAfterStartup && SDL_WaitEvent(&event) && event.type != SDL_QUIT)
 	{
 		switch (g_currentMode)
 		{
@@ -170,12 +222,99 @@ int main(int argc, char *argv[])
 	}
 
 	editor.closeLevel(false);
+	Font::closeAll();
 	g_window.destroy();
 
 	TTF_Quit();
 	SDL_Quit();
 
-	return EXIT_SUCCESS;
+	return startupOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//Handles the headless modes that run from the command line without opening a window
+int commandLine(int argc, char *argv[])
+{
+	string mode;
+	fs::path input;
+	fs::path output;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if ((arg == "--render-pack" || arg == "--validate" || arg == "--stats" || arg == "--export" || arg == "--import") && i + 1 < argc)
+		{
+			mode = arg;
+			input = argv[++i];
+		}
+		else if (arg == "--verify-data")
+		{
+			mode = arg;
+		}
+		else if (arg == "--out" && i + 1 < argc)
+		{
+			output = argv[++i];
+		}
+		else
+		{
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (mode.empty() || (mode != "--validate" && mode != "--stats" && mode != "--verify-data" && output.empty()))
+	{
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	if (SDL_Init(0))
+	{
+		SDL_Log("failed to initialize SDL: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	// Archives only move level files around, so they don't need the game data
+	if (mode == "--export" || mode == "--import")
+	{
+		bool success = (mode == "--export") ? PackArchive::exportPack(input, output) : PackArchive::importPack(input, output);
+		SDL_Quit();
+		return success ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	Ini ini;
+	if (!ini.load() || !ini.validateData())
+	{
+		SDL_Log("Couldn't find the Lemmings 3 data. Run lem3edit once without any options to set it up.\n");
+		SDL_Quit();
+		return EXIT_FAILURE;
+	}
+
+	bool success = false;
+	if (mode == "--render-pack")
+		success = Render::renderPack(ini.lem3cdPath.parent_path(), input, output);
+	else if (mode == "--validate")
+		success = Validate::validatePath(ini.lem3cdPath.parent_path(), input, output);
+	else if (mode == "--stats")
+		success = Stats::statsPath(ini.lem3cdPath.parent_path(), input, output);
+	else if (mode == "--verify-data")
+		success = ini.verifyData();
+
+	SDL_Quit();
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void usage(void)
+{
+	SDL_Log("Usage: %s [options]\n", prog_name);
+	SDL_Log("Run without any options to open the editor.\n");
+	SDL_Log("  --startup-trace [--out <file.json>] [--budget <ms>]  Open the editor and time each phase of startup, with --budget quit once the menu is drawn and fail if it took longer\n");
+	SDL_Log("  --render-pack <pack.l3pack|pack.l3arc> --out <folder>  Render every level in a pack to BMP files\n");
+	SDL_Log("  --validate <pack.l3pack|pack.l3arc|folder> [--out <file.json>]  Check every level for problems and report them as JSON\n");
+	SDL_Log("  --stats <pack.l3pack|pack.l3arc|folder> [--out <file.csv>]  Print object counts, coverage and style use for every level\n");
+	SDL_Log("  --verify-data  Check the Lemmings 3 data files still match what was found at setup\n");
+	SDL_Log("  --export <pack.l3pack|folder> --out <pack.l3arc>  Pack every level into a single archive file\n");
+	SDL_Log("  --import <pack.l3arc> --out <folder>  Unpack an archive into loose level files\n");
 }
 
 void die(void)
@@ -53,6 +53,20 @@ fs::path l3_filename_data(const fs::path basePath, const std::string &folder, co
 fs::path l3_filename_level(const fs::path parentPath, const std::string &name, const std::string &ext);
 fs::path l3_filename_level(const fs::path parentPath, const std::string &name, int n, const std::string &ext);
 
+// Lemmings 3 files are little-endian whatever the host is
+inline Uint16 l3_read_le16(const Uint8 *p) { return (Uint16)(p[0] | (p[1] << 8)); }
+inline void l3_write_le16(Uint8 *p, Uint16 value) { p[0] = value & 0xFF; p[1] = value >> 8; }
+inline Uint32 l3_read_le32(const Uint8 *p) { return l3_read_le16(p) | ((Uint32)l3_read_le16(p + 2) << 16); }
+inline void l3_write_le32(Uint8 *p, Uint32 value) { l3_write_le16(p, value & 0xFFFF); l3_write_le16(p + 2, value >> 16); }
+
+// FNV-1a content hash, pass the previous result back in to hash data in pieces
+inline Uint64 l3_hash(const Uint8 *data, size_t size, Uint64 h = 14695981039346656037ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+		h = (h ^ data[i]) * 1099511628211ULL;
+	return h;
+}
+
 void die(void);
 
 #endif // LEM3EDIT_HPP
@@ -22,6 +22,7 @@
 #include "lem3edit.hpp"
 #include "level.hpp"
 #include "style.hpp"
+#include "transaction.hpp"
 
 #include <cassert>
 #include <experimental/filesystem>
@@ -58,8 +59,8 @@ void Level::draw_objects(signed int x, signed int xOffset, signed int y, signed
 		if (so == -1)
 			continue;
 
-		int onScreenX = (o.x - x)*zoom - xOffset;
-		int onScreenY = (o.y - y)*zoom - yOffset;
+		int onScreenX = (objectX(o) - x)*zoom - xOffset;
+		int onScreenY = (objectY(o) - y)*zoom - yOffset;
 		if (onScreenY < g_window.height - BAR_HEIGHT)
 		{
 			style_ptr->draw_object_texture(onScreenX, onScreenY, type, so, zoom, 0);
@@ -67,66 +68,26 @@ void Level::draw_objects(signed int x, signed int xOffset, signed int y, signed
 	}
 }
 
-Level::Object::Index Level::get_object_by_position(signed int x, signed int y) const
-{
-	signed int i;
-
-	for (int j = 2; j >= 0; j--)
-	{
-		if (canvas_ptr->layerVisible[j])
-		{
-			i = get_object_by_position(x, y, j);
-			if (i != -1)
-				return Object::Index(j, i);
-		}
-	}
-
-	return Object::Index(0, -1);
-}
-
-signed int Level::get_object_by_position(signed int x, signed int y, int type) const
+//Moves the objects at the sorted positions to the front (end) or back (start) of their layer,
+//keeping the order within both groups. This is a stable partition done in one pass.
+//Handles to the objects stay valid.
+void Level::reorder_objects(int type, const vector<int> &positions, bool toFront)
 {
 	assert((unsigned)type < COUNTOF(this->object));
 
-	for (vector<Object>::const_reverse_iterator i = object[type].rbegin(); i != object[type].rend(); ++i)
-	{
-		const Object &o = *i;
-
-		if (x < o.x || y < o.y)
-			continue;
-
-		int so = style_ptr->object_by_id(type, o.id);
-		if (so == -1)
-			continue;
-
-		if (x < o.x + style_ptr->object[type][so].width * 8 && y < o.y + style_ptr->object[type][so].height * 2)
-			return object[type].rend() - i - 1; // index
-	}
-
-	return -1;
+	object[type].moveToEnd(positions, toFront);
 }
 
-std::vector<int> Level::get_objects_in_area(int areaX, int areaY, int areaW, int areaH, int type) const
+//Removes the objects at the sorted positions with a single mark and compact pass.
+//Returns where every old position ended up, -1 for removed objects, so anything
+//holding object indexes can be fixed up in one sweep. Handles need no fixing up.
+vector<int> Level::remove_objects(int type, const vector<int> &positions)
 {
-	vector<int> tmp;
+	assert((unsigned)type < COUNTOF(this->object));
 
-	for (vector<Object>::const_reverse_iterator i = object[type].rbegin(); i != object[type].rend(); ++i)
-	{
-		const Object &o = *i;
-		int so = style_ptr->object_by_id(type, o.id);
-		if (so == -1)
-			continue;
-		if (areaX >= o.x + style_ptr->object[type][so].width * 8)
-			continue;
-		if (areaY >= o.y + style_ptr->object[type][so].height * 2)
-			continue;
-		if (areaX + areaW < o.x)
-			continue;
-		if (areaY + areaH < o.y)
-			continue;
-		tmp.push_back(object[type].rend() - i - 1);
-	}
-	return tmp;
+	vector<int> remap;
+	object[type].removeAt(positions, &remap);
+	return remap;
 }
 
 //Creates a new level.
@@ -140,6 +101,7 @@ void Level::newLevel(const fs::path filename, const tribeName t, const int n)
 	object[TEMP].clear();
 	object[PERM].clear();
 	object[TOOL].clear();
+	originX = originY = 0;
 
 	switch (t)
 	{
@@ -182,6 +144,7 @@ bool Level::load(const fs::path filename)
 	string levelNum = filename.stem().generic_string();
 	levelNum = levelNum.substr(5, 8);
 	level_id = atoi(levelNum.c_str());
+	originX = originY = 0;
 
 	return load_level(filename) &&
 		load_objects(PERM, levelPath.parent_path(), "PERM", perm) &&
@@ -204,22 +167,9 @@ bool Level::load_level(const fs::path filename)
 		return false;
 	}
 
-	f.read((char *)&tribe, sizeof(tribe));
-	f.read((char *)&cave_map, sizeof(cave_map));
-	f.read((char *)&cave_raw, sizeof(cave_raw));
-	f.read((char *)&temp, sizeof(temp));
-	f.read((char *)&perm, sizeof(perm));
-	f.read((char *)&style, sizeof(style));
-	f.read((char *)&width, sizeof(width));
-	f.read((char *)&height, sizeof(height));
-	f.read((char *)&cameraX, sizeof(cameraX));
-	f.read((char *)&cameraY, sizeof(cameraY));
-	f.read((char *)&time, sizeof(time));
-	f.read((char *)&extra_lemmings, sizeof(extra_lemmings));
-	f.read((char *)&unknown, sizeof(unknown));
-	f.read((char *)&release_rate, sizeof(release_rate));
-	f.read((char *)&release_delay, sizeof(release_delay));
-	f.read((char *)&enemies, sizeof(enemies));
+	Uint8 buffer[DAT_SIZE] = { 0 };
+	f.read((char *)buffer, DAT_SIZE);
+	decode_level(buffer);
 
 	SDL_Log("Loaded level from  '%s'\n", filename.generic_string().c_str());
 
@@ -230,6 +180,26 @@ bool Level::load_level(const fs::path filename)
 	return true;
 }
 
+void Level::decode_level(const Uint8 *buffer)
+{
+	tribe = l3_read_le16(buffer + 0);
+	cave_map = l3_read_le16(buffer + 2);
+	cave_raw = l3_read_le16(buffer + 4);
+	temp = l3_read_le16(buffer + 6);
+	perm = l3_read_le16(buffer + 8);
+	style = l3_read_le16(buffer + 10);
+	width = l3_read_le16(buffer + 12);
+	height = l3_read_le16(buffer + 14);
+	cameraX = (Sint16)l3_read_le16(buffer + 16);
+	cameraY = (Sint16)l3_read_le16(buffer + 18);
+	time = l3_read_le16(buffer + 20);
+	extra_lemmings = buffer[22];
+	unknown = buffer[23];
+	release_rate = l3_read_le16(buffer + 24);
+	release_delay = l3_read_le16(buffer + 26);
+	enemies = l3_read_le16(buffer + 28);
+}
+
 bool Level::load_objects(int type, const fs::path parentPath, const string &name, unsigned int n)
 {
 	assert((unsigned)type < COUNTOF(this->object));
@@ -247,23 +217,42 @@ bool Level::load_objects(int type, const fs::path filename)
 	if (type == PERM)
 		object[TOOL].clear();
 
-	ifstream f(filename, ios::binary);
+	ifstream f(filename, ios::binary | ios::ate);
 	if (!f)
 	{
 		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
 		return false;
 	}
 
-	while (true)
+	// Read the whole file in one go
+	streamoff size = f.tellg();
+	f.seekg(0);
+	vector<Uint8> buffer(size > 0 ? (size_t)size : 0);
+	if (!buffer.empty())
+		f.read((char *)&buffer[0], buffer.size());
+
+	decode_objects(type, buffer.data(), buffer.size());
+
+	if (type == PERM)
+		SDL_Log("Loaded %d + %d objects from '%s'\n", object[type].size(), object[TOOL].size(), filename.generic_string().c_str());
+	if (type == TEMP)
+		SDL_Log("Loaded %d objects from '%s'\n", object[type].size(), filename.generic_string().c_str());
+	f.close();
+	return true;
+}
+
+void Level::decode_objects(int type, const Uint8 *buffer, size_t size)
+{
+	const size_t count = size / OBS_RECORD_SIZE;
+	object[type].reserve(object[type].size() + count);
+	for (size_t i = 0; i < count; ++i)
 	{
+		const Uint8 *record = &buffer[i * OBS_RECORD_SIZE];
 		Object o;
 
-		f.read((char *)&o.id, sizeof(o.id));
-		f.read((char *)&o.x, sizeof(o.x));
-		f.read((char *)&o.y, sizeof(o.y));
-
-		if (!f)
-			break;
+		o.id = l3_read_le16(record);
+		o.x = (Sint16)l3_read_le16(record + 2);
+		o.y = (Sint16)l3_read_le16(record + 4);
 
 		if (o.id < 5000)
 		{
@@ -274,56 +263,72 @@ bool Level::load_objects(int type, const fs::path filename)
 			object[TOOL].push_back(o);
 		}
 	}
+}
 
-	if (type == PERM)
-		SDL_Log("Loaded %d + %d objects from '%s'\n", object[type].size(), object[TOOL].size(), filename.generic_string().c_str());
-	if (type == TEMP)
-		SDL_Log("Loaded %d objects from '%s'\n", object[type].size(), filename.generic_string().c_str());
-	f.close();
-	return true;
+//Check if object has invalid id or lies entirely outside level borders
+Level::objectProblem Level::check_object(const Object * o, const int type) const
+{
+	int so = style_ptr->object_by_id(type, o->id);
+	if (so == -1)
+		return OBJECT_INVALID_ID;
+
+	int w = style_ptr->object[type][so].width * 8;
+	int h = style_ptr->object[type][so].height * 2;
+
+	if (objectX(*o) + w <= 0 || objectY(*o) + h <= 0 || objectX(*o) >= width || objectY(*o) >= height)
+		return OBJECT_OUTSIDE_BORDER;
+
+	return OBJECT_OK;
 }
 
 //Return if object has invalid id or lies entirely outside level borders
 bool Level::validate(const Object * o, const int type)
 {
-	int so = style_ptr->object_by_id(type, o->id);
-	if (so == -1)
+	switch (check_object(o, type))
 	{
+	case OBJECT_INVALID_ID:
 		SDL_Log("Didn't save invalid object type: %d\n", o->id);
 		return false;
-	}
-
-	int w = style_ptr->object[type][so].width * 8;
-	int h = style_ptr->object[type][so].height * 2;
-	bool outsideBorder = false;
-
-	if (o->x + w <= 0)
-		outsideBorder = true;
-	if (o->y + h <= 0)
-		outsideBorder = true;
-	if (o->x >= width)
-		outsideBorder = true;
-	if (o->y >= height)
-		outsideBorder = true;
-
-	if (outsideBorder)
+	case OBJECT_OUTSIDE_BORDER:
 	{
-		SDL_Log("Didn't save object outside borders: ID %d, X %d, Y %d, W %d, H %d\n", o->id, o->x, o->y, w, h);
+		int so = style_ptr->object_by_id(type, o->id);
+		int w = style_ptr->object[type][so].width * 8;
+		int h = style_ptr->object[type][so].height * 2;
+		SDL_Log("Didn't save object outside borders: ID %d, X %d, Y %d, W %d, H %d\n", o->id, objectX(*o), objectY(*o), w, h);
 		return false;
 	}
-
-	return true;
+	default:
+		return true;
+	}
 }
 
 bool Level::save(const bool giveFeedback)
 {
+	// levels read out of a .l3arc have no files of their own to write back to
+	if (levelPath.empty())
+	{
+		SDL_Log("Level::save: Level %d has no file to save to\n", level_id);
+		return false;
+	}
+
+	foldOrigin();
 	enemies = 0;
 	extra_lemmings = 0;
 
-	if (save_objects(PERM, levelPath.parent_path(), perm) &&
-		save_objects(TEMP, levelPath.parent_path(), temp) &&
-		save_level(levelPath) == true)
+	// The tool counts in the header come from encoding the objects, so the DAT goes last
+	const fs::path parentPath = levelPath.parent_path();
+	vector<Uint8> permData, tempData, levelData;
+	int count = encode_objects(PERM, permData);
+	count += encode_objects(TEMP, tempData);
+	encode_level(levelData);
+
+	SaveTransaction transaction(parentPath);
+	if (transaction.add(l3_filename_level(parentPath, "PERM", perm, "OBS"), permData) &&
+		transaction.add(l3_filename_level(parentPath, "TEMP", temp, "OBS"), tempData) &&
+		transaction.add(levelPath, levelData) &&
+		transaction.commit())
 	{
+		SDL_Log("Wrote level and %d objects to '%s'\n", count, levelPath.generic_string().c_str());
 		if (giveFeedback)
 			SDL_ShowSimpleMessageBox(0, "Save Complete", "Level saved!", NULL);
 	}
@@ -342,35 +347,37 @@ bool Level::save_level(const fs::path parentPath, unsigned int n)
 
 bool Level::save_level(const fs::path filename)
 {
-	ofstream f(filename, ios::binary | ios::trunc);
-	if (!f)
-	{
-		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+	vector<Uint8> buffer;
+	encode_level(buffer);
+	if (!SaveTransaction::writeFileSynced(filename, buffer))
 		return false;
-	}
-
-	f.write((char *)&tribe, sizeof(tribe));
-	f.write((char *)&cave_map, sizeof(cave_map));
-	f.write((char *)&cave_raw, sizeof(cave_raw));
-	f.write((char *)&temp, sizeof(temp));
-	f.write((char *)&perm, sizeof(perm));
-	f.write((char *)&style, sizeof(style));
-	f.write((char *)&width, sizeof(width));
-	f.write((char *)&height, sizeof(height));
-	f.write((char *)&cameraX, sizeof(cameraX));
-	f.write((char *)&cameraY, sizeof(cameraY));
-	f.write((char *)&time, sizeof(time));
-	f.write((char *)&extra_lemmings, sizeof(extra_lemmings));
-	f.write((char *)&unknown, sizeof(unknown));
-	f.write((char *)&release_rate, sizeof(release_rate));
-	f.write((char *)&release_delay, sizeof(release_delay));
-	f.write((char *)&enemies, sizeof(enemies));
 
 	SDL_Log("Wrote level to '%s'\n", filename.generic_string().c_str());
-	f.close();
 	return true;
 }
 
+void Level::encode_level(vector<Uint8> &buffer) const
+{
+	buffer.resize(DAT_SIZE);
+
+	l3_write_le16(&buffer[0], tribe);
+	l3_write_le16(&buffer[2], cave_map);
+	l3_write_le16(&buffer[4], cave_raw);
+	l3_write_le16(&buffer[6], temp);
+	l3_write_le16(&buffer[8], perm);
+	l3_write_le16(&buffer[10], style);
+	l3_write_le16(&buffer[12], width);
+	l3_write_le16(&buffer[14], height);
+	l3_write_le16(&buffer[16], (Uint16)cameraX);
+	l3_write_le16(&buffer[18], (Uint16)cameraY);
+	l3_write_le16(&buffer[20], time);
+	buffer[22] = extra_lemmings;
+	buffer[23] = unknown;
+	l3_write_le16(&buffer[24], release_rate);
+	l3_write_le16(&buffer[26], release_delay);
+	l3_write_le16(&buffer[28], enemies);
+}
+
 bool Level::save_objects(int type, fs::path parentPath, unsigned int n)
 {
 	assert((unsigned)type < COUNTOF(this->object));
@@ -389,44 +396,58 @@ bool Level::save_objects(int type, const fs::path filename)
 {
 	assert((unsigned)type < COUNTOF(this->object));
 
-	ofstream f(filename, ios::binary | ios::trunc);
-	if (!f)
-	{
-		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+	vector<Uint8> buffer;
+	int count = encode_objects(type, buffer);
+	if (!SaveTransaction::writeFileSynced(filename, buffer))
 		return false;
-	}
 
-	int count = 0;
+	SDL_Log("Wrote %d objects to '%s'\n", count, filename.generic_string().c_str());
+	return true;
+}
+
+// Encodes every valid object of a type into one buffer, counting the tools the header needs
+int Level::encode_objects(int type, vector<Uint8> &buffer)
+{
+	assert((unsigned)type < COUNTOF(this->object));
+
 	int numTypesToSave = 1;
 	int savingType = type;
+	size_t maxCount = object[type].size();
 	if (type == PERM)
+	{
 		numTypesToSave = 2;
+		maxCount += object[TOOL].size();
+	}
+
+	buffer.resize(maxCount * OBS_RECORD_SIZE);
+	int count = 0;
 	for (int j = 0; j < numTypesToSave; j++)
 	{
 		for (vector<Object>::const_iterator i = object[savingType].begin(); i != object[savingType].end(); ++i)
 		{
 			const Object &o = *i;
-			if (validate(&o, savingType))
-			{
-				count++;
-				f.write((char *)&o.id, sizeof(o.id));
-				f.write((char *)&o.x, sizeof(o.x));
-				f.write((char *)&o.y, sizeof(o.y));
-				if (o.id == 10006 || o.id == 10007)
-					extra_lemmings++;
-				if (o.id >= 10010 && o.id <= 10017)
-					enemies++;
-			}
+			if (!validate(&o, savingType))
+				continue;
+
+			Uint8 *record = &buffer[count * OBS_RECORD_SIZE];
+			l3_write_le16(record, o.id);
+			l3_write_le16(record + 2, (Uint16)objectX(o));
+			l3_write_le16(record + 4, (Uint16)objectY(o));
+			count++;
+
+			if (o.isExtraLemming())
+				extra_lemmings++;
+			if (o.isEnemy())
+				enemies++;
 		}
 		savingType = TOOL;
 	}
+	buffer.resize(count * OBS_RECORD_SIZE);
 
-	SDL_Log("Wrote %d objects to '%s'\n", count, filename.generic_string().c_str());
-
-	f.close();
-	return true;
+	return count;
 }
 
+//Shifting only moves the origin, so this takes the same time however many objects there are
 void Level::resizeLevel(int delta_x, int delta_y, bool shiftLevel)
 {
 	width += delta_x;
@@ -434,24 +455,8 @@ void Level::resizeLevel(int delta_x, int delta_y, bool shiftLevel)
 
 	if (shiftLevel)
 	{
-		for (vector<Object>::iterator i = object[PERM].begin(); i != object[PERM].end(); ++i)
-		{
-			Object &o = *i;
-			o.x += delta_x;
-			o.y += delta_y;
-		}
-		for (vector<Object>::iterator i = object[TEMP].begin(); i != object[TEMP].end(); ++i)
-		{
-			Object &o = *i;
-			o.x += delta_x;
-			o.y += delta_y;
-		}
-		for (vector<Object>::iterator i = object[TOOL].begin(); i != object[TOOL].end(); ++i)
-		{
-			Object &o = *i;
-			o.x += delta_x;
-			o.y += delta_y;
-		}
+		originX += delta_x;
+		originY += delta_y;
 		cameraX += delta_x;
 		cameraY += delta_y;
 	}
@@ -465,3 +470,20 @@ void Level::resizeLevel(int delta_x, int delta_y, bool shiftLevel)
 	if (cameraY + 160 > height)
 		cameraY = height - 160;
 }
+
+//Moves the origin into the object coordinates, so they are the real positions again
+void Level::foldOrigin(void)
+{
+	if (originX == 0 && originY == 0)
+		return;
+
+	for (int type = 0; type < 3; ++type)
+	{
+		for (vector<Object>::iterator i = object[type].begin(); i != object[type].end(); ++i)
+		{
+			i->x += originX;
+			i->y += originY;
+		}
+	}
+	originX = originY = 0;
+}
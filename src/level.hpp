@@ -21,6 +21,7 @@
 #define LEVEL_HPP
 
 #include "lem3edit.hpp"
+#include "slotmap.hpp"
 
 #include "SDL.h"
 
@@ -55,6 +56,10 @@ public:
 	Uint16 release_rate, release_delay;
 	Uint16 enemies;
 
+	// Sizes of the DAT header and of one OBS record on disk
+	static const int DAT_SIZE = 30;
+	static const int OBS_RECORD_SIZE = 6;
+
 	class Object
 	{
 	public:
@@ -69,41 +74,78 @@ public:
 			inline bool operator<(const Index &that) const { return this->type != that.type ? this->type < that.type : this->i < that.i; }
 		};
 
+		// Refers to the same object however the layer is reordered, until the object is removed
+		class Handle
+		{
+		public:
+			int type;
+			Uint32 slot;
+			Uint32 generation;
+
+			Handle(int type, Uint32 slot, Uint32 generation) : type(type), slot(slot), generation(generation) { }
+		};
+
 		Uint16 id;
 		Sint16 x, y;
+
+		// The tools the DAT header keeps a count of, see encode_objects
+		bool isExtraLemming(void) const { return id == 10006 || id == 10007; }
+		bool isEnemy(void) const { return id >= 10010 && id <= 10017; }
 	};
 
-	std::vector<Object> object[3];
+	SlotMap<Object> object[3];
+
+	// Shifting the level moves this instead of every object, so object coordinates are
+	// relative to it until save() folds it back in. Use objectX/Y and placeObject to get
+	// and set where objects really are.
+	int originX, originY;
+
+	int objectX(const Object &o) const { return o.x + originX; }
+	int objectY(const Object &o) const { return o.y + originY; }
+	void placeObject(Object &o, int x, int y) const { o.x = x - originX; o.y = y - originY; }
+	// A copy holding the real position, for keeping objects outside the level
+	Object absolute(const Object &o) const { Object a = o; a.x = objectX(o); a.y = objectY(o); return a; }
+	void foldOrigin(void);
+
+	Object::Handle handle(const Object::Index &index) const { return Object::Handle(index.type, object[index.type].slotAt(index.i), object[index.type].generationOf(object[index.type].slotAt(index.i))); }
+	// i is -1 if the object has been removed
+	Object::Index index(const Object::Handle &handle) const { return Object::Index(handle.type, object[handle.type].positionOf(handle.slot, handle.generation)); }
 
 	void setReferences(Canvas * c, Style * s);
 
 	void draw(signed int x, signed int xOffset, signed int y, signed int yOffset, int zoom) const;
 	void draw_objects(signed int x, signed int xOffset, signed int y, signed int yOffset, int type, int zoom) const;
 
-	Object::Index get_object_by_position(signed int x, signed int y) const;
-	signed int get_object_by_position(signed int x, signed int y, int type) const;
-
-	std::vector<int> get_objects_in_area(int areaX, int areaY, int areaW, int areaH, int type) const;
+	void reorder_objects(int type, const std::vector<int> &positions, bool toFront);
+	std::vector<int> remove_objects(int type, const std::vector<int> &positions);
 
 	void newLevel(const fs::path filename, const tribeName t, const int n);
 
 	bool load(const fs::path filename);
 	bool load_level(const std::string &path, const std::string &name, unsigned int n);
 	bool load_level(const fs::path filename);
+	void decode_level(const Uint8 *buffer);
 	bool load_objects(int type, const fs::path parentPath, const std::string &name, unsigned int n);
 	bool load_objects(int type, const fs::path filename);
+	// Adds the objects in size bytes of OBS records, any partial record at the end is ignored
+	void decode_objects(int type, const Uint8 *buffer, size_t size);
 
+	enum objectProblem { OBJECT_OK, OBJECT_INVALID_ID, OBJECT_OUTSIDE_BORDER };
+	objectProblem check_object(const Object * o, const int type) const;
 	bool validate(const Object * o, const int type);
 
+	// Saves the DAT and both OBS files together, see SaveTransaction
 	bool save(const bool giveFeedback);
 	bool save_level(const fs::path parentPath, unsigned int n);
 	bool save_level(const fs::path filename);
 	bool save_objects(int type, const fs::path parentPath, unsigned int n);
 	bool save_objects(int type, const fs::path filename);
+	void encode_level(std::vector<Uint8> &buffer) const;
+	int encode_objects(int type, std::vector<Uint8> &buffer);
 
 	void resizeLevel(int delta_x, int delta_y, bool shiftLevel);
 
-	Level(void) { /* nothing to do */ }
+	Level(void) : originX(0), originY(0) { }
 
 private:
 	Level(const Level &);
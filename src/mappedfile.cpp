@@ -0,0 +1,189 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+This file includes code for mapping files into memory
+*/
+
+#include "mappedfile.hpp"
+
+#include "SDL.h"
+
+#include <experimental/filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::experimental::filesystem::v1;
+
+MappedFile::MappedFile(void) : view(NULL), length(0), writable(false)
+{
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	file = -1;
+#endif
+}
+
+bool MappedFile::open(const fs::path filename)
+{
+	return map(filename, 0, false);
+}
+
+bool MappedFile::create(const fs::path filename, size_t size)
+{
+	return map(filename, size, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const fs::path filename, size_t size, bool forWriting)
+{
+	close();
+
+	file = CreateFileW(filename.wstring().c_str(), forWriting ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, forWriting ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+		return false;
+	}
+
+	if (!forWriting)
+	{
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			close();
+			return false;
+		}
+		size = (size_t)fileSize.QuadPart;
+	}
+
+	length = size;
+	writable = forWriting;
+	if (size == 0) // nothing to map, but the file is open
+		return true;
+
+	mapping = CreateFileMappingW(file, NULL, forWriting ? PAGE_READWRITE : PAGE_READONLY, (DWORD)((Uint64)size >> 32), (DWORD)size, NULL);
+	if (mapping != NULL)
+		view = (Uint8 *)MapViewOfFile(mapping, forWriting ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (view == NULL)
+	{
+		SDL_Log("Failed to map '%s'\n", filename.generic_string().c_str());
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	if (view != NULL)
+	{
+		if (writable)
+			FlushViewOfFile(view, 0);
+		UnmapViewOfFile(view);
+	}
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	view = NULL;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+	length = 0;
+	writable = false;
+}
+
+#else
+
+bool MappedFile::map(const fs::path filename, size_t size, bool forWriting)
+{
+	close();
+
+	file = ::open(filename.string().c_str(), forWriting ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+	if (file == -1)
+	{
+		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+		return false;
+	}
+
+	if (forWriting)
+	{
+		if (ftruncate(file, size) != 0)
+		{
+			SDL_Log("Failed to resize '%s'\n", filename.generic_string().c_str());
+			close();
+			return false;
+		}
+	}
+	else
+	{
+		struct stat info;
+		if (fstat(file, &info) != 0)
+		{
+			close();
+			return false;
+		}
+		size = info.st_size;
+	}
+
+	length = size;
+	writable = forWriting;
+	if (size == 0) // mmap refuses empty mappings, but the file is open
+		return true;
+
+	void *address = mmap(NULL, size, forWriting ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+	if (address == MAP_FAILED)
+	{
+		SDL_Log("Failed to map '%s'\n", filename.generic_string().c_str());
+		close();
+		return false;
+	}
+	view = (Uint8 *)address;
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	if (view != NULL)
+	{
+		if (writable)
+			msync(view, length, MS_SYNC);
+		munmap(view, length);
+	}
+	if (file != -1)
+		::close(file);
+
+	view = NULL;
+	file = -1;
+	length = 0;
+	writable = false;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "SDL.h"
+
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+// A file mapped into memory, so it can be read or written in place without copying it
+// through a buffer. The mapping is released when the object is destroyed.
+class MappedFile
+{
+public:
+	// Maps an existing file for reading
+	bool open(const fs::path filename);
+	// Creates or truncates a file of the given size and maps it for writing
+	bool create(const fs::path filename, size_t size);
+	void close(void);
+
+	const Uint8 * data(void) const { return view; }
+	Uint8 * writableData(void) { return writable ? view : NULL; }
+	size_t size(void) const { return length; }
+
+	MappedFile(void);
+	~MappedFile(void) { close(); }
+
+private:
+	Uint8 *view;
+	size_t length;
+	bool writable;
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#else
+	int file;
+#endif
+
+	bool map(const fs::path filename, size_t size, bool forWriting);
+
+	MappedFile(const MappedFile &);
+	MappedFile & operator=(const MappedFile &);
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,103 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for reading the level list out of a .l3pack file
+ */
+
+#include "lem3edit.hpp"
+#include "pack.hpp"
+
+#include "SDL.h"
+
+#include <fstream>
+#include <string>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+bool Pack::readEntries(const fs::path packPath, vector<Entry> &entries, int &version)
+{
+	entries.clear();
+
+	ifstream packFile(packPath);
+	if (!packFile.is_open())
+	{
+		SDL_Log("readEntries: Couldn't open level pack %s\n.", packPath.generic_string().c_str());
+		return false;
+	}
+
+	return readEntries(packFile, entries, version);
+}
+
+bool Pack::readEntries(istream &packFile, vector<Entry> &entries, int &version)
+{
+	entries.clear();
+
+	string line;
+	int count = 1;
+
+	while (getline(packFile, line))
+	{
+		string::size_type pos = line.find('=');
+		if (pos == string::npos)
+			continue;
+
+		string key = line.substr(0, pos);
+		string value = line.substr(pos + 1);
+
+		if (key == "VERSION")
+		{
+			//load pack version so we can handle backwards compatability if the format ever changes
+			version = atoi(value.c_str());
+			continue;
+		}
+
+		int id = atoi(key.c_str());
+
+		tribeName loadingTribe;
+		if (id >= 1 && id <= 30)
+			loadingTribe = CLASSIC;
+		else if (id >= 101 && id <= 130)
+			loadingTribe = SHADOW;
+		else if (id >= 201 && id <= 230)
+			loadingTribe = EGYPT;
+		else
+		{
+			SDL_Log("readEntries: Invalid pack file entry - Invalid id");
+			return false;
+		}
+
+		count++;
+		if (id % 100 == 1)
+			count = 1 + (loadingTribe * 100);
+
+		if (id != count)
+		{
+			SDL_Log("readEntries: Invalid pack file entry - Level id out of order");
+			return false;
+		}
+
+		entries.emplace_back(Entry(id, loadingTribe, value));
+	}
+
+	return true;
+}
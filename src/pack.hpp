@@ -0,0 +1,50 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef PACK_HPP
+#define PACK_HPP
+
+#include "lem3edit.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Pack
+{
+public:
+	class Entry
+	{
+	public:
+		int id;
+		tribeName tribe;
+		std::string name;
+
+		Entry(int id, tribeName tribe, const std::string &name) : id(id), tribe(tribe), name(name) { }
+	};
+
+	//reads the list of levels from a .l3pack file, checking the ids are valid and in order
+	static bool readEntries(const fs::path packPath, std::vector<Entry> &entries, int &version);
+	static bool readEntries(std::istream &packFile, std::vector<Entry> &entries, int &version);
+};
+
+#endif // PACK_HPP
@@ -0,0 +1,285 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for the cache of level headers kept beside a level pack
+ */
+
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "mappedfile.hpp"
+#include "packindex.hpp"
+
+#include "SDL.h"
+
+#include <cstring>
+#include <fstream>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// "L3IX", version, entry count
+#define HEADER_SIZE 8
+// id, DAT header, then size and time of each file
+#define ENTRY_SIZE (2 + Level::DAT_SIZE + PackIndex::FILE_COUNT * 12)
+#define VERSION 1
+
+static const char *filePrefix[PackIndex::FILE_COUNT] = { "LEVEL", "PERM", "TEMP" };
+static const char *fileExt[PackIndex::FILE_COUNT] = { "DAT", "OBS", "OBS" };
+
+int PackIndex::Entry::objectCount(int type) const
+{
+	if (type == PERM)
+		return (int)(size[1] / Level::OBS_RECORD_SIZE);
+	if (type == TEMP)
+		return (int)(size[2] / Level::OBS_RECORD_SIZE);
+	return 0;
+}
+
+bool PackIndex::Entry::sameFiles(const Entry &other) const
+{
+	for (int f = 0; f < FILE_COUNT; ++f)
+	{
+		if (size[f] != other.size[f] || time[f] != other.time[f])
+			return false;
+	}
+	return true;
+}
+
+fs::path PackIndex::pathFor(const fs::path packPath)
+{
+	fs::path indexPath = packPath;
+	indexPath.replace_extension(".l3index");
+	return indexPath;
+}
+
+void PackIndex::load(const fs::path packPath)
+{
+	this->packPath = packPath;
+	entries.clear();
+	changed = false;
+
+	fs::path source = pathFor(packPath);
+	error_code ec;
+	if (!fs::exists(source, ec))
+		return;
+
+	MappedFile file;
+	if (!file.open(source))
+		return;
+
+	const Uint8 *p = file.data();
+	if (file.size() < HEADER_SIZE || memcmp(p, "L3IX", 4) != 0 || l3_read_le16(p + 4) != VERSION)
+	{
+		SDL_Log("Ignoring '%s', it is not a lem3edit pack index\n", source.generic_string().c_str());
+		return;
+	}
+
+	const Uint16 count = l3_read_le16(p + 6);
+	if (file.size() < HEADER_SIZE + (size_t)count * ENTRY_SIZE)
+	{
+		SDL_Log("Ignoring '%s', it is cut short\n", source.generic_string().c_str());
+		return;
+	}
+	p += HEADER_SIZE;
+
+	for (int i = 0; i < count; ++i, p += ENTRY_SIZE)
+	{
+		Entry &e = entries[l3_read_le16(p)];
+		memcpy(e.header, p + 2, Level::DAT_SIZE);
+		const Uint8 *stamp = p + 2 + Level::DAT_SIZE;
+		for (int f = 0; f < FILE_COUNT; ++f, stamp += 12)
+		{
+			e.size[f] = l3_read_le32(stamp);
+			e.time[f] = (Sint64)(l3_read_le32(stamp + 4) | ((Uint64)l3_read_le32(stamp + 8) << 32));
+		}
+	}
+}
+
+bool PackIndex::save(void)
+{
+	if (!changed || packPath.empty())
+		return true;
+
+	// Written under a temporary name then renamed, like the clipboard
+	fs::path target = pathFor(packPath);
+	fs::path staged = target;
+	staged += ".new";
+
+	{
+		MappedFile file;
+		if (!file.create(staged, HEADER_SIZE + entries.size() * ENTRY_SIZE))
+			return false;
+
+		Uint8 *p = file.writableData();
+		memcpy(p, "L3IX", 4);
+		l3_write_le16(p + 4, VERSION);
+		l3_write_le16(p + 6, (Uint16)entries.size());
+		p += HEADER_SIZE;
+
+		for (map<int, Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i, p += ENTRY_SIZE)
+		{
+			l3_write_le16(p, (Uint16)i->first);
+			memcpy(p + 2, i->second.header, Level::DAT_SIZE);
+			Uint8 *stamp = p + 2 + Level::DAT_SIZE;
+			for (int f = 0; f < FILE_COUNT; ++f, stamp += 12)
+			{
+				l3_write_le32(stamp, (Uint32)i->second.size[f]);
+				l3_write_le32(stamp + 4, (Uint32)((Uint64)i->second.time[f] & 0xFFFFFFFF));
+				l3_write_le32(stamp + 8, (Uint32)((Uint64)i->second.time[f] >> 32));
+			}
+		}
+	}
+
+	error_code ec;
+	fs::rename(staged, target, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to write '%s'\n", target.generic_string().c_str());
+		fs::remove(staged, ec);
+		return false;
+	}
+	changed = false;
+	return true;
+}
+
+void PackIndex::fill(LevelBatch &batch)
+{
+	vector<char> cached(batch.items.size(), false);
+	map<int, Entry> current;
+
+	for (unsigned int i = 0; i < batch.items.size(); ++i)
+	{
+		LevelBatch::Item &item = batch.items[i];
+
+		// the folder listing already has every size and time, so this costs nothing extra
+		Entry stamp;
+		bool complete = true;
+		for (int f = 0; f < FILE_COUNT; ++f)
+		{
+			const LevelBatch::File *file = batch.file(filePrefix[f], item.id, fileExt[f]);
+			if (file == NULL)
+			{
+				complete = false;
+				break;
+			}
+			stamp.size[f] = file->size;
+			stamp.time[f] = file->time;
+		}
+		if (!complete)
+			continue;
+
+		map<int, Entry>::const_iterator e = entries.find(item.id);
+		if (e != entries.end() && e->second.sameFiles(stamp))
+		{
+			item.header.assign(e->second.header, e->second.header + Level::DAT_SIZE);
+			current[item.id] = e->second;
+			cached[i] = true;
+		}
+		else
+		{
+			current[item.id] = stamp;
+		}
+	}
+
+	batch.loadHeaders();
+
+	for (unsigned int i = 0; i < batch.items.size(); ++i)
+	{
+		const LevelBatch::Item &item = batch.items[i];
+		map<int, Entry>::iterator e = current.find(item.id);
+		if (cached[i] || e == current.end())
+			continue;
+
+		if (item.header.size() == Level::DAT_SIZE)
+		{
+			memcpy(e->second.header, item.header.data(), Level::DAT_SIZE);
+			changed = true;
+		}
+		else
+		{
+			current.erase(e);
+		}
+	}
+
+	if (current.size() != entries.size())
+		changed = true;
+	entries.swap(current);
+	save();
+}
+
+const PackIndex::Entry * PackIndex::level(int id)
+{
+	Entry stamp;
+	if (!stampFiles(id, stamp))
+	{
+		forget(id);
+		return NULL;
+	}
+
+	map<int, Entry>::iterator e = entries.find(id);
+	if (e != entries.end() && e->second.sameFiles(stamp))
+		return &e->second;
+
+	if (!readHeader(l3_filename_level(packPath.parent_path(), "LEVEL", id, "DAT"), stamp.header))
+	{
+		forget(id);
+		return NULL;
+	}
+
+	entries[id] = stamp;
+	changed = true;
+	return &entries[id];
+}
+
+void PackIndex::forget(int id)
+{
+	if (entries.erase(id) > 0)
+		changed = true;
+}
+
+bool PackIndex::readHeader(const fs::path datPath, Uint8 *header)
+{
+	ifstream f(datPath, ios::binary);
+	if (!f || !f.read((char *)header, Level::DAT_SIZE))
+	{
+		SDL_Log("PackIndex: Failed to read the header of '%s'\n", datPath.generic_string().c_str());
+		return false;
+	}
+	return true;
+}
+
+bool PackIndex::stampFiles(int id, Entry &entry) const
+{
+	for (int f = 0; f < FILE_COUNT; ++f)
+	{
+		fs::path filePath = l3_filename_level(packPath.parent_path(), filePrefix[f], id, fileExt[f]);
+		error_code ec;
+		entry.size[f] = fs::file_size(filePath, ec);
+		if (ec)
+			return false;
+		entry.time[f] = fs::last_write_time(filePath, ec).time_since_epoch().count();
+		if (ec)
+			return false;
+	}
+	return true;
+}
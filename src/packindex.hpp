@@ -0,0 +1,82 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef PACKINDEX_HPP
+#define PACKINDEX_HPP
+
+#include "level.hpp"
+
+#include "SDL.h"
+
+#include <map>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class LevelBatch;
+
+// Level headers cached next to a .l3pack, so the pack views only read the levels that changed
+class PackIndex
+{
+public:
+	// the LEVEL, PERM and TEMP files of a level, in that order
+	static const int FILE_COUNT = 3;
+
+	class Entry
+	{
+	public:
+		Uint8 header[Level::DAT_SIZE];
+		uintmax_t size[FILE_COUNT];
+		Sint64 time[FILE_COUNT];
+
+		// PERM or TEMP, worked out from the OBS file size
+		int objectCount(int type) const;
+		bool sameFiles(const Entry &other) const;
+	};
+
+	std::map<int, Entry> entries;
+
+	// <pack>.l3index beside <pack>.l3pack
+	static fs::path pathFor(const fs::path packPath);
+
+	// A missing or outdated index just starts out empty
+	void load(const fs::path packPath);
+	bool save(void);
+
+	// Gives every level in the batch its header, reading only those whose files changed since they were cached
+	void fill(LevelBatch &batch);
+
+	// Checks one level against its files and re-reads it if they changed, NULL if it can't be read.
+	// Doesn't write the index, so callers looking up several levels save once afterwards.
+	const Entry * level(int id);
+
+	// For levels whose files were moved around, which can keep their old times
+	void forget(int id);
+
+	PackIndex(void) : changed(false) { }
+
+private:
+	fs::path packPath;
+	bool changed;
+
+	static bool readHeader(const fs::path datPath, Uint8 *header);
+	bool stampFiles(int id, Entry &entry) const;
+};
+
+#endif // PACKINDEX_HPP
@@ -0,0 +1,85 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains a small helper for spreading independent jobs across threads
+ */
+
+#include "parallel.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	class ParallelJobs
+	{
+	public:
+		const function<void(int)> *job;
+		int count;
+		SDL_atomic_t next;
+	};
+
+	int parallel_worker(void *data)
+	{
+		ParallelJobs *jobs = (ParallelJobs *)data;
+
+		int i;
+		while ((i = SDL_AtomicAdd(&jobs->next, 1)) < jobs->count)
+			(*jobs->job)(i);
+
+		return 0;
+	}
+}
+
+void parallel_for(int count, const function<void(int)> &job)
+{
+	if (count <= 0)
+		return;
+
+	ParallelJobs jobs;
+	jobs.job = &job;
+	jobs.count = count;
+	SDL_AtomicSet(&jobs.next, 0);
+
+	int threadCount = min(max(SDL_GetCPUCount(), 1), count);
+
+	vector<SDL_Thread *> threads;
+	for (int i = 1; i < threadCount; ++i)
+	{
+		SDL_Thread *t = SDL_CreateThread(parallel_worker, "parallel_for", &jobs);
+		if (t == NULL)
+		{
+			SDL_Log("parallel_for: Failed to create thread: %s\n", SDL_GetError());
+			break;
+		}
+		threads.push_back(t);
+	}
+
+	// this thread does its share of the work too, and picks up everything if no threads could start
+	parallel_worker(&jobs);
+
+	for (vector<SDL_Thread *>::const_iterator t = threads.begin(); t != threads.end(); ++t)
+		SDL_WaitThread(*t, NULL);
+}
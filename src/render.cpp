@@ -0,0 +1,149 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for rendering levels to image files from the command line
+ */
+
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "parallel.hpp"
+#include "render.hpp"
+#include "style.hpp"
+#include "tribe.hpp"
+
+#include "SDL.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// Palette index past the end of the tribe and style colours, used for the black level background
+#define BACKGROUND_COLOUR 255
+
+bool Render::renderPack(const fs::path dataPath, const fs::path packPath, const fs::path outPath)
+{
+	LevelBatch batch;
+	if (!batch.find(packPath))
+		return false;
+
+	error_code ec;
+	fs::create_directories(outPath, ec);
+	if (ec)
+	{
+		SDL_Log("renderPack: Couldn't create output folder '%s'\n", outPath.generic_string().c_str());
+		return false;
+	}
+
+	batch.loadLevels();
+	batch.loadStyles(dataPath);
+
+	map< int, unique_ptr<Tribe> > tribes;
+	for (vector<LevelBatch::Item>::const_iterator i = batch.items.begin(); i != batch.items.end(); ++i)
+	{
+		if (i->loaded && tribes.find(i->level->tribe) == tribes.end())
+			tribes[i->level->tribe].reset(new Tribe());
+	}
+	for (map< int, unique_ptr<Tribe> >::iterator i = tribes.begin(); i != tribes.end();)
+	{
+		if (i->second->load_palette(dataPath, "GRAPHICS", "TRIBE", i->first))
+			++i;
+		else
+			i = tribes.erase(i);
+	}
+
+	const int count = batch.items.size();
+	SDL_atomic_t failures;
+	SDL_AtomicSet(&failures, 0);
+	parallel_for(count, [&](int i)
+	{
+		const LevelBatch::Item &item = batch.items[i];
+		if (!item.loaded)
+		{
+			SDL_AtomicAdd(&failures, 1);
+			return;
+		}
+
+		const Level &level = *item.level;
+		const Style *style = batch.style(level.style);
+		map< int, unique_ptr<Tribe> >::const_iterator tribe = tribes.find(level.tribe);
+		if (style == NULL || tribe == tribes.end())
+		{
+			SDL_Log("renderPack: Missing style %d or tribe %d for level %d\n", level.style, level.tribe, item.id);
+			SDL_AtomicAdd(&failures, 1);
+			return;
+		}
+
+		SDL_Surface *surface = renderLevel(level, *style, tribe->second->palette);
+		if (surface == NULL)
+		{
+			SDL_Log("renderPack: Couldn't create surface for level %d: %s\n", item.id, SDL_GetError());
+			SDL_AtomicAdd(&failures, 1);
+			return;
+		}
+
+		fs::path imagePath = l3_filename_level(outPath, "LEVEL", item.id, "bmp");
+		if (SDL_SaveBMP(surface, imagePath.generic_string().c_str()) != 0)
+		{
+			SDL_Log("renderPack: Couldn't write '%s': %s\n", imagePath.generic_string().c_str(), SDL_GetError());
+			SDL_AtomicAdd(&failures, 1);
+		}
+		SDL_FreeSurface(surface);
+	});
+
+	int failed = SDL_AtomicGet(&failures);
+	SDL_Log("Rendered %d of %d levels to '%s'\n", count - failed, count, outPath.generic_string().c_str());
+	return failed == 0;
+}
+
+SDL_Surface * Render::renderLevel(const Level &level, const Style &style, const SDL_Color *tribePalette)
+{
+	SDL_Surface *surface = SDL_CreateRGBSurface(0, level.width, level.height, 8, 0, 0, 0, 0);
+	if (surface == NULL)
+		return NULL;
+
+	// Same palette layout as Style::create_object_textures
+	SDL_SetPaletteColors(surface->format->palette, tribePalette, 0, 32);
+	SDL_SetPaletteColors(surface->format->palette, style.palette, 32, 209);
+	SDL_Color black = { 0, 0, 0, 255 };
+	SDL_SetPaletteColors(surface->format->palette, &black, BACKGROUND_COLOUR, 1);
+	SDL_FillRect(surface, NULL, BACKGROUND_COLOUR);
+
+	for (int type = 0; type < 3; ++type)
+	{
+		for (vector<Level::Object>::const_iterator i = level.object[type].begin(); i != level.object[type].end(); ++i)
+		{
+			int so = style.object_by_id(type, i->id);
+			if (so == -1)
+				continue;
+
+			style.blit_object(surface, level.objectX(*i), level.objectY(*i), type, so, 0);
+			if (style.object[type][so].frame.size() > 1)
+				style.blit_object(surface, level.objectX(*i), level.objectY(*i), type, so, 1);
+		}
+	}
+
+	return surface;
+}
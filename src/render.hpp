@@ -0,0 +1,42 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include "SDL.h"
+
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class Level;
+class Style;
+
+class Render
+{
+public:
+	// Renders every level in a pack to an 8 bit BMP inside outPath. Needs no window.
+	static bool renderPack(const fs::path dataPath, const fs::path packPath, const fs::path outPath);
+
+	// Returns a new 8 bit surface the size of the level using the game's palettes. Caller frees it.
+	static SDL_Surface * renderLevel(const Level &level, const Style &style, const SDL_Color *tribePalette);
+};
+
+#endif // RENDER_HPP
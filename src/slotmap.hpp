@@ -0,0 +1,325 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SLOTMAP_HPP
+#define SLOTMAP_HPP
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// A vector that also gives every element a slot number that stays the same while the
+// element is moved around, plus a generation that changes once it is removed.
+// Elements are kept densely in order, so iterating and indexing work like a std::vector.
+template <class T>
+class SlotMap
+{
+public:
+	typedef typename std::vector<T>::iterator iterator;
+	typedef typename std::vector<T>::const_iterator const_iterator;
+	typedef typename std::vector<T>::const_reverse_iterator const_reverse_iterator;
+
+	iterator begin(void) { return values.begin(); }
+	iterator end(void) { return values.end(); }
+	const_iterator begin(void) const { return values.begin(); }
+	const_iterator end(void) const { return values.end(); }
+	const_reverse_iterator rbegin(void) const { return values.rbegin(); }
+	const_reverse_iterator rend(void) const { return values.rend(); }
+
+	size_t size(void) const { return values.size(); }
+	bool empty(void) const { return values.empty(); }
+	T & operator[](size_t position) { return values[position]; }
+	const T & operator[](size_t position) const { return values[position]; }
+	T & back(void) { return values.back(); }
+	const T & back(void) const { return values.back(); }
+	const std::vector<T> & dense(void) const { return values; }
+
+	Uint32 slotAt(size_t position) const { return slotOf[position]; }
+	Uint32 generationOf(Uint32 slot) const { return slots[slot].generation; }
+	size_t slotCount(void) const { return slots.size(); }
+
+	// Returns -1 if the slot has been removed since the generation was taken
+	int positionOf(Uint32 slot, Uint32 generation) const
+	{
+		if (slot >= slots.size() || slots[slot].generation != generation || slots[slot].position == FREE)
+			return -1;
+		return slots[slot].position;
+	}
+
+	void reserve(size_t n)
+	{
+		values.reserve(n);
+		slotOf.reserve(n);
+	}
+
+	void clear(void)
+	{
+		while (!values.empty())
+			pop_back();
+	}
+
+	Uint32 push_back(const T &value)
+	{
+		values.push_back(value);
+		slotOf.push_back(allocate(values.size() - 1));
+		return slotOf.back();
+	}
+
+	void pop_back(void)
+	{
+		release(slotOf.back());
+		values.pop_back();
+		slotOf.pop_back();
+	}
+
+	void assign(const std::vector<T> &newValues)
+	{
+		clear();
+		reserve(newValues.size());
+		for (typename std::vector<T>::const_iterator i = newValues.begin(); i != newValues.end(); ++i)
+			push_back(*i);
+	}
+
+	// The edits below only touch the elements from the first given position to the end, or
+	// from the start to the last given position when working at the start, so a change near
+	// the end of a long vector is cheap. Elements outside that range stay where they are.
+
+	// Removes the elements at the sorted positions in one pass
+	void removeAt(const std::vector<int> &positions, std::vector<int> *remap)
+	{
+		const size_t first = positions.empty() ? values.size() : positions.front();
+		if (remap != NULL)
+		{
+			remap->assign(values.size(), -1);
+			for (size_t i = 0; i < first; ++i)
+				(*remap)[i] = i;
+		}
+
+		std::vector<int>::const_iterator next = positions.begin();
+		size_t kept = first;
+		for (size_t i = first; i < values.size(); ++i)
+		{
+			if (next != positions.end() && *next == (int)i)
+			{
+				release(slotOf[i]);
+				++next;
+				continue;
+			}
+			if (remap != NULL)
+				(*remap)[i] = kept;
+			place(kept++, values[i], slotOf[i]);
+		}
+		values.resize(kept);
+		slotOf.resize(kept);
+	}
+
+	// Inserts new elements so they end up at the sorted positions, in one pass
+	void insertAt(const std::vector<int> &positions, const std::vector<T> &newValues)
+	{
+		std::vector<Uint32> newSlots(newValues.size());
+		for (size_t i = 0; i < newValues.size(); ++i)
+			newSlots[i] = allocate(0);
+
+		const size_t oldSize = values.size();
+		values.resize(oldSize + newValues.size());
+		slotOf.resize(oldSize + newValues.size());
+		mergeFromEnd(oldSize, positions, newValues, newSlots);
+	}
+
+	// Stable partition, moving the elements at the sorted positions to the end or the start.
+	// The elements keep their slots.
+	void moveToEnd(const std::vector<int> &positions, bool toEnd)
+	{
+		if (positions.empty())
+			return;
+
+		std::vector<T> moved;
+		std::vector<Uint32> movedSlots;
+		moved.reserve(positions.size());
+		movedSlots.reserve(positions.size());
+
+		if (toEnd)
+		{
+			const size_t first = positions.front();
+			std::vector<int>::const_iterator next = positions.begin();
+			size_t kept = first;
+			for (size_t i = first; i < values.size(); ++i)
+			{
+				if (next != positions.end() && *next == (int)i)
+				{
+					moved.push_back(values[i]);
+					movedSlots.push_back(slotOf[i]);
+					++next;
+				}
+				else
+				{
+					values[kept] = values[i];
+					slotOf[kept] = slotOf[i];
+					kept++;
+				}
+			}
+			std::copy(moved.begin(), moved.end(), values.begin() + kept);
+			std::copy(movedSlots.begin(), movedSlots.end(), slotOf.begin() + kept);
+			renumber(first, values.size());
+		}
+		else
+		{
+			// the same walking down from the last position, so moved comes out backwards
+			const size_t last = positions.back();
+			std::vector<int>::const_reverse_iterator next = positions.rbegin();
+			size_t kept = last + 1;
+			for (size_t i = last + 1; i-- > 0;)
+			{
+				if (next != positions.rend() && *next == (int)i)
+				{
+					moved.push_back(values[i]);
+					movedSlots.push_back(slotOf[i]);
+					++next;
+				}
+				else
+				{
+					kept--;
+					values[kept] = values[i];
+					slotOf[kept] = slotOf[i];
+				}
+			}
+			std::copy(moved.rbegin(), moved.rend(), values.begin());
+			std::copy(movedSlots.rbegin(), movedSlots.rend(), slotOf.begin());
+			renumber(0, last + 1);
+		}
+	}
+
+	// Undoes moveToEnd, putting the block at the end or start back at the sorted positions
+	void moveBack(const std::vector<int> &positions, bool fromEnd)
+	{
+		const size_t count = positions.size();
+		assert(count <= values.size());
+		if (count == 0)
+			return;
+
+		typename std::vector<T>::iterator block = fromEnd ? values.end() - count : values.begin();
+		std::vector<Uint32>::iterator blockSlots = fromEnd ? slotOf.end() - count : slotOf.begin();
+		std::vector<T> moved(block, block + count);
+		std::vector<Uint32> movedSlots(blockSlots, blockSlots + count);
+		if (fromEnd)
+			mergeFromEnd(values.size() - count, positions, moved, movedSlots);
+		else
+			mergeFromStart(count, positions, moved, movedSlots);
+	}
+
+	SlotMap(void) { /* nothing to do */ }
+
+private:
+	static const Uint32 FREE = 0xFFFFFFFF;
+
+	class Slot
+	{
+	public:
+		Uint32 position;
+		Uint32 generation;
+	};
+
+	std::vector<T> values;
+	std::vector<Uint32> slotOf; // position -> slot
+	std::vector<Slot> slots; // slot -> position
+	std::vector<Uint32> freeSlots;
+
+	Uint32 allocate(Uint32 position)
+	{
+		Uint32 slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = slots.size();
+			Slot s;
+			s.generation = 0;
+			slots.push_back(s);
+		}
+		slots[slot].position = position;
+		return slot;
+	}
+
+	void release(Uint32 slot)
+	{
+		slots[slot].position = FREE;
+		slots[slot].generation++;
+		freeSlots.push_back(slot);
+	}
+
+	void place(size_t position, const T &value, Uint32 slot)
+	{
+		values[position] = value;
+		slotOf[position] = slot;
+		slots[slot].position = position;
+	}
+
+	void renumber(size_t from, size_t to)
+	{
+		for (size_t i = from; i < to; ++i)
+			slots[slotOf[i]].position = i;
+	}
+
+	// The old elements fill [0, oldEnd) and the rest of the vector is free. Walks down from the
+	// end moving them up to make room, stopping once the new element at the first position is in.
+	void mergeFromEnd(size_t oldEnd, const std::vector<int> &positions, const std::vector<T> &newValues, const std::vector<Uint32> &newSlots)
+	{
+		size_t fromOld = oldEnd, fromNew = newValues.size();
+		for (size_t i = values.size(); fromNew > 0;)
+		{
+			--i;
+			if (positions[fromNew - 1] == (int)i)
+			{
+				fromNew--;
+				place(i, newValues[fromNew], newSlots[fromNew]);
+			}
+			else
+			{
+				fromOld--;
+				place(i, values[fromOld], slotOf[fromOld]);
+			}
+		}
+	}
+
+	// The mirror image, with the old elements starting at oldBegin and the space before it free
+	void mergeFromStart(size_t oldBegin, const std::vector<int> &positions, const std::vector<T> &newValues, const std::vector<Uint32> &newSlots)
+	{
+		size_t fromOld = oldBegin, fromNew = 0;
+		for (size_t i = 0; fromNew < newValues.size(); ++i)
+		{
+			if (positions[fromNew] == (int)i)
+			{
+				place(i, newValues[fromNew], newSlots[fromNew]);
+				fromNew++;
+			}
+			else
+			{
+				place(i, values[fromOld], slotOf[fromOld]);
+				fromOld++;
+			}
+		}
+	}
+};
+
+#endif // SLOTMAP_HPP
@@ -0,0 +1,213 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for reporting statistics about every level in a pack from the command line
+ */
+
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "style.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// Objects are sized in steps of 8 pixels across and 2 down, so coverage is counted in cells that size
+#define CELL_WIDTH 8
+#define CELL_HEIGHT 2
+
+Stats::LevelStats::LevelStats(void) : measured(false), width(0), height(0), unknownObjects(0), extraLemmings(0), enemies(0), coverage(0), overlap(0)
+{
+	objects[PERM] = objects[TEMP] = objects[TOOL] = 0;
+}
+
+static string csvField(const string &s)
+{
+	if (s.find_first_of(",\"\n") == string::npos)
+		return s;
+
+	string quoted = "\"";
+	for (string::const_iterator i = s.begin(); i != s.end(); ++i)
+	{
+		if (*i == '"')
+			quoted += '"';
+		quoted += *i;
+	}
+	return quoted + "\"";
+}
+
+bool Stats::statsPath(const fs::path dataPath, const fs::path path, const fs::path csvPath)
+{
+	LevelBatch batch;
+	if (!batch.find(path))
+		return false;
+
+	// Styles are decoded once each and shared by every level that uses them
+	batch.loadLevels();
+	batch.loadStyles(dataPath);
+
+	vector<LevelStats> stats(batch.items.size());
+	parallel_for(batch.items.size(), [&](int i)
+	{
+		measureLevel(batch, i, stats[i]);
+	});
+
+	ostringstream table, csv;
+	char line[256];
+	snprintf(line, sizeof(line), "%5s  %-24s %5s %9s %5s %5s %5s %5s %5s %5s %8s %7s\n",
+		"ID", "Name", "Style", "Size", "Perm", "Temp", "Tool", "Bad", "Extra", "Enemy", "Coverage", "Overlap");
+	table << line;
+	csv << "id,name,style,width,height,area,perm,temp,tool,unknown,extra_lemmings,enemies,coverage,overlap\n";
+
+	LevelStats total;
+	map<int, int> styleUse;
+	int measured = 0;
+	long long totalArea = 0;
+	for (unsigned int i = 0; i < batch.items.size(); ++i)
+	{
+		const LevelBatch::Item &item = batch.items[i];
+		const LevelStats &s = stats[i];
+		if (!s.measured)
+		{
+			snprintf(line, sizeof(line), "%5d  %-24.24s couldn't be loaded\n", item.id, item.name.c_str());
+			table << line;
+			continue;
+		}
+
+		const int style = item.level->style;
+		snprintf(line, sizeof(line), "%5d  %-24.24s %5d %4dx%-4d %5d %5d %5d %5d %5d %5d %7.1f%% %7.2f\n",
+			item.id, item.name.c_str(), style, s.width, s.height, s.objects[PERM], s.objects[TEMP], s.objects[TOOL],
+			s.unknownObjects, s.extraLemmings, s.enemies, s.coverage * 100, s.overlap);
+		table << line;
+		csv << item.id << "," << csvField(item.name) << "," << style << "," << s.width << "," << s.height << "," << s.width * s.height << ","
+			<< s.objects[PERM] << "," << s.objects[TEMP] << "," << s.objects[TOOL] << "," << s.unknownObjects << ","
+			<< s.extraLemmings << "," << s.enemies << "," << s.coverage << "," << s.overlap << "\n";
+
+		measured++;
+		styleUse[style]++;
+		totalArea += (long long)s.width * s.height;
+		for (int type = 0; type < 3; ++type)
+			total.objects[type] += s.objects[type];
+		total.unknownObjects += s.unknownObjects;
+		total.extraLemmings += s.extraLemmings;
+		total.enemies += s.enemies;
+	}
+
+	snprintf(line, sizeof(line), "%5s  %-24s %5s %9s %5d %5d %5d %5d %5d %5d\n",
+		"", "Total", "", "", total.objects[PERM], total.objects[TEMP], total.objects[TOOL], total.unknownObjects, total.extraLemmings, total.enemies);
+	table << line;
+	table << "\n" << measured << " of " << batch.items.size() << " levels measured, total area " << totalArea << " pixels\n";
+	table << "Style use:\n";
+	for (map<int, int>::const_iterator i = styleUse.begin(); i != styleUse.end(); ++i)
+	{
+		snprintf(line, sizeof(line), "  style %d  %3d levels  %s\n", i->first, i->second, string(i->second, '#').c_str());
+		table << line;
+	}
+
+	cout << table.str();
+	cout.flush();
+
+	if (!csvPath.empty())
+	{
+		ofstream f(csvPath, ios::trunc);
+		if (!f)
+		{
+			SDL_Log("statsPath: Failed to open '%s'\n", csvPath.generic_string().c_str());
+			return false;
+		}
+		f << csv.str();
+	}
+
+	return measured == (int)batch.items.size();
+}
+
+void Stats::measureLevel(const LevelBatch &batch, int i, LevelStats &stats)
+{
+	const LevelBatch::Item &item = batch.items[i];
+	if (!item.loaded)
+		return;
+
+	const Level &level = *item.level;
+	stats.measured = true;
+	stats.width = level.width;
+	stats.height = level.height;
+
+	for (vector<Level::Object>::const_iterator o = level.object[TOOL].begin(); o != level.object[TOOL].end(); ++o)
+	{
+		if (o->isExtraLemming())
+			stats.extraLemmings++;
+		if (o->isEnemy())
+			stats.enemies++;
+	}
+
+	// Count how many objects lie over each cell of the level
+	const Style *style = batch.style(level.style);
+	const int columns = (level.width + CELL_WIDTH - 1) / CELL_WIDTH;
+	const int rows = (level.height + CELL_HEIGHT - 1) / CELL_HEIGHT;
+	vector<Uint16> cells((size_t)columns * rows, 0);
+
+	for (int type = 0; type < 3; ++type)
+	{
+		stats.objects[type] = level.object[type].size();
+		for (vector<Level::Object>::const_iterator o = level.object[type].begin(); o != level.object[type].end(); ++o)
+		{
+			const int so = style == NULL ? -1 : style->object_by_id(type, o->id);
+			if (so == -1)
+			{
+				stats.unknownObjects++;
+				continue;
+			}
+
+			const int x = level.objectX(*o), y = level.objectY(*o);
+			const int left = BETWEEN(0, x / CELL_WIDTH, columns), right = BETWEEN(0, (x + style->object[type][so].width * 8 + CELL_WIDTH - 1) / CELL_WIDTH, columns);
+			const int top = BETWEEN(0, y / CELL_HEIGHT, rows), bottom = BETWEEN(0, (y + style->object[type][so].height * 2 + CELL_HEIGHT - 1) / CELL_HEIGHT, rows);
+			for (int row = top; row < bottom; ++row)
+				for (int column = left; column < right; ++column)
+					if (cells[(size_t)row * columns + column] < 0xFFFF)
+						cells[(size_t)row * columns + column]++;
+		}
+	}
+
+	size_t covered = 0, layers = 0;
+	for (vector<Uint16>::const_iterator c = cells.begin(); c != cells.end(); ++c)
+	{
+		if (*c > 0)
+		{
+			covered++;
+			layers += *c;
+		}
+	}
+	stats.coverage = cells.empty() ? 0 : (double)covered / cells.size();
+	stats.overlap = covered == 0 ? 0 : (double)layers / covered;
+}
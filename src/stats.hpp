@@ -0,0 +1,53 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class LevelBatch;
+
+class Stats
+{
+public:
+	class LevelStats
+	{
+	public:
+		bool measured;
+		int width, height;
+		int objects[3]; // PERM, TEMP, TOOL
+		int unknownObjects; // ids the style doesn't have, left out of the coverage
+		int extraLemmings, enemies; // counted from the tools, as Level::save_objects does
+		double coverage; // fraction of the level under at least one object
+		double overlap; // average number of objects over each covered part
+
+		LevelStats(void);
+	};
+
+	// Measures every level in a pack, archive or folder, prints a table to stdout
+	// and writes the same figures as CSV to csvPath if it isn't empty
+	static bool statsPath(const fs::path dataPath, const fs::path path, const fs::path csvPath);
+
+	static void measureLevel(const LevelBatch &batch, int i, LevelStats &stats);
+};
+
+#endif // STATS_HPP
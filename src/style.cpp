@@ -59,6 +59,7 @@ void Style::Object::copy(const Style::Object &that)
 		memcpy(temp, *f, sizeof(Uint16) * width * height);
 		frame.push_back(temp);
 	}
+	mask = that.mask;
 }
 
 void Style::Object::destroy(void)
@@ -68,6 +69,58 @@ void Style::Object::destroy(void)
 		delete[] * f;
 }
 
+void Style::Object::build_masks(void)
+{
+	const int rowWords = (width + 63) / 64;
+
+	mask.clear();
+	for (vector<Uint16 *>::const_iterator f = frame.begin(); f != frame.end(); ++f)
+	{
+		vector<Uint64> bits(rowWords * height, 0);
+		int i = 0;
+		for (int by = 0; by < height; ++by)
+		{
+			for (int bx = 0; bx < width; ++bx)
+			{
+				if ((*f)[i++] != (Uint16)-1)
+					bits[by * rowWords + bx / 64] |= (Uint64)1 << (bx % 64);
+			}
+		}
+		mask.push_back(bits);
+	}
+
+	// An object that draws nothing would be impossible to click on, so treat it as solid instead
+	bool drawn = false;
+	for (unsigned int f = 0; f < mask.size() && f < 2; ++f)
+		drawn = drawn || find_if(mask[f].begin(), mask[f].end(), [](Uint64 word) { return word != 0; }) != mask[f].end();
+	if (!drawn && !mask.empty())
+	{
+		for (int by = 0; by < height; ++by)
+			for (int bx = 0; bx < width; ++bx)
+				mask[0][by * rowWords + bx / 64] |= (Uint64)1 << (bx % 64);
+	}
+}
+
+bool Style::Object::opaque_at(signed int x, signed int y) const
+{
+	if (x < 0 || y < 0 || x >= width * 8 || y >= height * 2)
+		return false;
+	if (mask.empty())
+		return true;
+
+	const int rowWords = (width + 63) / 64;
+	const int bx = x / 8, by = y / 2;
+	const int word = by * rowWords + bx / 64;
+	const Uint64 bit = (Uint64)1 << (bx % 64);
+
+	for (unsigned int f = 0; f < mask.size() && f < 2; ++f)
+	{
+		if (mask[f][word] & bit)
+			return true;
+	}
+	return false;
+}
+
 void Style::Block::blit(SDL_Surface *dest, signed int x, signed int y) const
 {
 	for (int by = 0; by < 2; ++by)
@@ -213,6 +266,14 @@ void Style::draw_object_texture(signed int x, signed int y, int type, unsigned i
 }
 
 bool Style::load(unsigned int n, SDL_Color *pal2, fs::path basePath)
+{
+	return load_data(n, basePath) &&
+		create_object_textures(PERM, pal2) &&
+		create_object_textures(TEMP, pal2) &&
+		create_object_textures(TOOL, pal2);
+}
+
+bool Style::load_data(unsigned int n, fs::path basePath)
 {
 	const string folder = "STYLES";
 	const string data = "DATA";
@@ -224,10 +285,7 @@ bool Style::load(unsigned int n, SDL_Color *pal2, fs::path basePath)
 		load_blocks(PERM, basePath, folder, perm, n) &&
 		load_objects(TEMP, basePath, folder, temp, n) &&
 		load_blocks(TEMP, basePath, folder, temp, n) &&
-		skill.load(basePath, folder, objec, n) &&
-		create_object_textures(PERM, pal2) &&
-		create_object_textures(TEMP, pal2) &&
-		create_object_textures(TOOL, pal2);
+		skill.load(basePath, folder, objec, n);
 }
 
 bool Style::load_palette(fs::path basePath, string folder, string name, unsigned int n)
@@ -377,6 +435,7 @@ bool Style::load_objects(int type, const fs::path obj_filename, const fs::path f
 
 			o.frame.push_back(frame);
 		}
+		o.build_masks();
 
 		if (o.id < 5000)
 		{
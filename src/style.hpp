@@ -47,6 +47,13 @@ public:
 		Uint16 frl, unknown[4];
 
 		std::vector<Uint16 *> frame;
+		// For each frame, one bit per block set where a block is drawn, packed 64 to a word
+		// with each row of blocks starting on a new word. Blocks are solid, so this is exact.
+		std::vector< std::vector<Uint64> > mask;
+
+		void build_masks(void);
+		// Whether the pixel is drawn in the first two frames, which are what the editor shows
+		bool opaque_at(signed int x, signed int y) const;
 
 		Object(void) { /* nothing to do */ }
 		Object(const Object &that) { copy(that); }
@@ -87,6 +94,8 @@ public:
 	void draw_object_texture(signed int x, signed int y, int type, unsigned int object, int zoom, int maxSize) const;
 
 	bool load(unsigned int n, SDL_Color *pal2, fs::path basePath);
+	// Loads everything except the textures, so it can be used without a window
+	bool load_data(unsigned int n, fs::path basePath);
 	bool load_palette(fs::path basePath, std::string folder, std::string name, unsigned int n);
 	bool load_palette(fs::path pal_filename);
 	bool load_objects(int type, fs::path basePath, const std::string &folder, const std::string &name, unsigned int n);
@@ -0,0 +1,104 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for timing how long the editor takes to start up
+ */
+
+#include "trace.hpp"
+
+#include "SDL.h"
+
+#include <cstdio>
+#include <fstream>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+bool StartupTrace::on = false;
+Uint64 StartupTrace::origin = 0;
+vector<StartupTrace::Phase> StartupTrace::phases;
+
+void StartupTrace::start(void)
+{
+	on = true;
+	origin = SDL_GetPerformanceCounter();
+	phases.clear();
+}
+
+void StartupTrace::phase(const char *name)
+{
+	if (!on)
+		return;
+
+	finish();
+	phases.push_back({ name, SDL_GetPerformanceCounter(), 0 });
+}
+
+void StartupTrace::finish(void)
+{
+	if (on && !phases.empty() && phases.back().end == 0)
+		phases.back().end = SDL_GetPerformanceCounter();
+}
+
+double StartupTrace::toMs(Uint64 ticks)
+{
+	return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+bool StartupTrace::report(const fs::path jsonPath, double budgetMs)
+{
+	finish();
+	const Uint64 last = phases.empty() ? origin : phases.back().end;
+	const double totalMs = toMs(last - origin);
+
+	SDL_Log("Startup took %.2f ms\n", totalMs);
+	for (vector<Phase>::const_iterator i = phases.begin(); i != phases.end(); ++i)
+		SDL_Log("  %-28s %9.2f ms  (from %.2f ms)\n", i->name, toMs(i->end - i->start), toMs(i->start - origin));
+
+	// Complete events, timestamps in microseconds from the start of main
+	bool success = true;
+	ofstream f(jsonPath, ios::trunc);
+	if (f)
+	{
+		f << "{\n\t\"traceEvents\": [";
+		for (vector<Phase>::const_iterator i = phases.begin(); i != phases.end(); ++i)
+		{
+			char event[256];
+			snprintf(event, sizeof(event), "%s\n\t\t{ \"name\": \"%s\", \"cat\": \"startup\", \"ph\": \"X\", \"ts\": %.1f, \"dur\": %.1f, \"pid\": 1, \"tid\": 1 }",
+				i == phases.begin() ? "" : ",", i->name, toMs(i->start - origin) * 1000, toMs(i->end - i->start) * 1000);
+			f << event;
+		}
+		f << "\n\t],\n\t\"displayTimeUnit\": \"ms\"\n}\n";
+	}
+	if (!f)
+	{
+		SDL_Log("StartupTrace: Failed to write '%s'\n", jsonPath.generic_string().c_str());
+		success = false;
+	}
+
+	if (budgetMs > 0 && totalMs > budgetMs)
+	{
+		SDL_Log("Startup took %.2f ms, over the budget of %.2f ms\n", totalMs, budgetMs);
+		success = false;
+	}
+	return success;
+}
@@ -0,0 +1,62 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "SDL.h"
+
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+// Times each phase of launching the editor for --startup-trace. Nothing is recorded unless
+// start() was called, so the phase markers can stay in place for normal launches.
+class StartupTrace
+{
+public:
+	static void start(void);
+	static bool enabled(void) { return on; }
+
+	// Ends the running phase, if any, and begins the next
+	static void phase(const char *name);
+	static void finish(void);
+
+	// Prints every phase and writes them as Chrome trace events to jsonPath, which
+	// chrome://tracing and similar viewers can open. Returns false if writing failed
+	// or the whole launch took longer than budgetMs, pass 0 for no budget.
+	static bool report(const fs::path jsonPath, double budgetMs);
+
+private:
+	class Phase
+	{
+	public:
+		const char *name;
+		Uint64 start, end;
+	};
+
+	static bool on;
+	static Uint64 origin;
+	static std::vector<Phase> phases;
+
+	static double toMs(Uint64 ticks);
+};
+
+#endif // TRACE_HPP
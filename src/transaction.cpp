@@ -0,0 +1,508 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for replacing or renumbering several level files at once without leaving them mismatched after a crash
+ */
+
+#include "transaction.hpp"
+#include "lem3edit.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <experimental/filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+#define STAGED_EXTENSION ".new"
+#define JOURNAL_NAME "lem3edit.journal"
+
+SaveTransaction::SaveTransaction(const fs::path folder) : folder(folder), committed(false)
+{
+	/* nothing to do */
+}
+
+SaveTransaction::~SaveTransaction(void)
+{
+	if (!committed)
+		abort();
+}
+
+fs::path SaveTransaction::journalPath(const fs::path folder)
+{
+	return folder / JOURNAL_NAME;
+}
+
+fs::path SaveTransaction::stagedPath(const fs::path target)
+{
+	fs::path staged = target;
+	staged += STAGED_EXTENSION;
+	return staged;
+}
+
+bool SaveTransaction::writeFileSynced(const fs::path filename, const vector<Uint8> &data)
+{
+	FILE *f = fopen(filename.string().c_str(), "wb");
+	if (f == NULL)
+	{
+		SDL_Log("Failed to open '%s'\n", filename.generic_string().c_str());
+		return false;
+	}
+
+	bool success = (data.empty() || fwrite(&data[0], 1, data.size(), f) == data.size()) && fflush(f) == 0;
+#ifdef _WIN32
+	success = success && _commit(_fileno(f)) == 0;
+#else
+	success = success && fsync(fileno(f)) == 0;
+#endif
+	success = fclose(f) == 0 && success;
+
+	if (!success)
+		SDL_Log("Failed to write '%s'\n", filename.generic_string().c_str());
+	return success;
+}
+
+void SaveTransaction::syncFolder(const fs::path folder)
+{
+	// Makes the renames themselves durable, Windows has no equivalent for folders
+#ifndef _WIN32
+	int fd = open(folder.string().c_str(), O_RDONLY);
+	if (fd != -1)
+	{
+		fsync(fd);
+		close(fd);
+	}
+#endif
+}
+
+bool SaveTransaction::add(const fs::path target, const vector<Uint8> &data)
+{
+	targets.push_back(target);
+	return writeFileSynced(stagedPath(target), data);
+}
+
+bool SaveTransaction::commit(void)
+{
+	// Write the journal under a temporary name so it only appears once it is complete
+	string journal;
+	for (vector<fs::path>::const_iterator i = targets.begin(); i != targets.end(); ++i)
+		journal += i->filename().string() + "\n";
+
+	const fs::path journalFile = journalPath(folder);
+	const fs::path stagedJournal = stagedPath(journalFile);
+	error_code ec;
+	if (!writeFileSynced(stagedJournal, vector<Uint8>(journal.begin(), journal.end())))
+		return false;
+	fs::rename(stagedJournal, journalFile, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to create journal '%s'\n", journalFile.generic_string().c_str());
+		fs::remove(stagedJournal, ec);
+		return false;
+	}
+	syncFolder(folder);
+
+	// From here on the save counts as done, a failed rename is finished by recover()
+	committed = true;
+	for (vector<fs::path>::const_iterator i = targets.begin(); i != targets.end(); ++i)
+	{
+		fs::rename(stagedPath(*i), *i, ec);
+		if (ec)
+		{
+			SDL_Log("Failed to move '%s' into place, it will be retried on the next load\n", i->generic_string().c_str());
+			return false;
+		}
+	}
+	syncFolder(folder);
+
+	fs::remove(journalFile, ec);
+	return true;
+}
+
+void SaveTransaction::abort(void)
+{
+	error_code ec;
+	for (vector<fs::path>::const_iterator i = targets.begin(); i != targets.end(); ++i)
+		fs::remove(stagedPath(*i), ec);
+	targets.clear();
+}
+
+void SaveTransaction::recover(const fs::path folder)
+{
+	MoveTransaction::recover(folder);
+
+	error_code ec;
+	const fs::path journalFile = journalPath(folder);
+
+	if (fs::exists(journalFile, ec))
+	{
+		// Roll forward, every file listed was already synced before the journal was written
+		ifstream f(journalFile);
+		string name;
+		while (getline(f, name))
+		{
+			if (name.empty())
+				continue;
+			const fs::path target = folder / name;
+			if (fs::exists(stagedPath(target), ec))
+			{
+				fs::rename(stagedPath(target), target, ec);
+				if (ec)
+				{
+					SDL_Log("recover: Failed to move '%s' into place\n", target.generic_string().c_str());
+					return;
+				}
+				SDL_Log("recover: Finished interrupted save of '%s'\n", target.generic_string().c_str());
+			}
+		}
+		f.close();
+		syncFolder(folder);
+		fs::remove(journalFile, ec);
+	}
+
+	// Roll back, anything still staged belongs to a save that never reached its journal
+	vector<fs::path> discard;
+	for (fs::directory_iterator i(folder, ec); !ec && i != fs::directory_iterator(); i.increment(ec))
+	{
+		const fs::path staged = i->path();
+		if (staged.extension() != STAGED_EXTENSION)
+			continue;
+		const string ext = staged.stem().extension().string();
+		if (ext == ".DAT" || ext == ".OBS" || staged.filename() == JOURNAL_NAME STAGED_EXTENSION)
+			discard.push_back(staged);
+	}
+	for (vector<fs::path>::const_iterator i = discard.begin(); i != discard.end(); ++i)
+	{
+		fs::remove(*i, ec);
+		SDL_Log("recover: Discarded interrupted save '%s'\n", i->generic_string().c_str());
+	}
+}
+
+#define ASIDE_EXTENSION ".move"
+#define DROPPED_EXTENSION ".drop"
+#define MOVE_JOURNAL_NAME "lem3edit.moves"
+
+MoveTransaction::MoveTransaction(const fs::path folder) : folder(folder)
+{
+	/* nothing to do */
+}
+
+void MoveTransaction::move(const fs::path from, const fs::path to)
+{
+	steps.push_back({ MOVE, from, to, -1, vector<Uint8>() });
+}
+
+void MoveTransaction::copy(const fs::path from, const fs::path to)
+{
+	steps.push_back({ COPY, from, to, -1, vector<Uint8>() });
+}
+
+void MoveTransaction::write(const fs::path target, const vector<Uint8> &data)
+{
+	steps.push_back({ WRITE, fs::path(), target, -1, data });
+}
+
+void MoveTransaction::remove(const fs::path target)
+{
+	steps.push_back({ REMOVE, target, fs::path(), -1, vector<Uint8>() });
+}
+
+void MoveTransaction::setLevelId(const fs::path target, int id)
+{
+	for (vector<Step>::reverse_iterator i = steps.rbegin(); i != steps.rend(); ++i)
+	{
+		if (i->type != REMOVE && i->to == target)
+		{
+			i->levelId = id;
+			return;
+		}
+	}
+}
+
+void MoveTransaction::moveLevel(int from, int to)
+{
+	if (from == to)
+		return;
+
+	move(l3_filename_level(folder, "LEVEL", from, "DAT"), l3_filename_level(folder, "LEVEL", to, "DAT"));
+	move(l3_filename_level(folder, "TEMP", from, "OBS"), l3_filename_level(folder, "TEMP", to, "OBS"));
+	move(l3_filename_level(folder, "PERM", from, "OBS"), l3_filename_level(folder, "PERM", to, "OBS"));
+	setLevelId(l3_filename_level(folder, "LEVEL", to, "DAT"), to);
+}
+
+void MoveTransaction::removeLevel(int id)
+{
+	remove(l3_filename_level(folder, "LEVEL", id, "DAT"));
+	remove(l3_filename_level(folder, "TEMP", id, "OBS"));
+	remove(l3_filename_level(folder, "PERM", id, "OBS"));
+}
+
+fs::path MoveTransaction::asidePath(const Step &step)
+{
+	fs::path aside = (step.type == REMOVE) ? step.from : step.to;
+	aside += (step.type == REMOVE) ? DROPPED_EXTENSION : ASIDE_EXTENSION;
+	return aside;
+}
+
+fs::path MoveTransaction::journalPath(const fs::path folder)
+{
+	return folder / MOVE_JOURNAL_NAME;
+}
+
+bool MoveTransaction::writeJournal(const fs::path folder, const vector<Step> &steps, bool committed)
+{
+	string journal = committed ? "COMMITTED\n" : "PENDING\n";
+	for (vector<Step>::const_iterator i = steps.begin(); i != steps.end(); ++i)
+		journal += string(1, (char)i->type) + "\t" + to_string(i->levelId) + "\t" + i->from.string() + "\t" + i->to.string() + "\n";
+
+	// Replaces the previous journal in one rename so it is never seen half written
+	const fs::path journalFile = journalPath(folder);
+	const fs::path stagedJournal = SaveTransaction::stagedPath(journalFile);
+	error_code ec;
+	if (!SaveTransaction::writeFileSynced(stagedJournal, vector<Uint8>(journal.begin(), journal.end())))
+		return false;
+	fs::rename(stagedJournal, journalFile, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to write journal '%s'\n", journalFile.generic_string().c_str());
+		fs::remove(stagedJournal, ec);
+		return false;
+	}
+	SaveTransaction::syncFolder(folder);
+	return true;
+}
+
+bool MoveTransaction::setDatId(const fs::path datPath, int id)
+{
+	fstream f(datPath, ios_base::binary | ios_base::in | ios_base::out);
+	if (!f)
+	{
+		SDL_Log("Failed to open '%s'\n", datPath.generic_string().c_str());
+		return false;
+	}
+
+	// TEMP and PERM ids follow the tribe and cave fields
+	Uint8 ids[4];
+	l3_write_le16(ids, id);
+	l3_write_le16(ids + 2, id);
+	f.seekp(6);
+	f.write((const char *)ids, sizeof(ids));
+	f.close();
+	return !f.fail();
+}
+
+bool MoveTransaction::aside(const Step &step)
+{
+	error_code ec;
+	const fs::path asidePath = MoveTransaction::asidePath(step);
+
+	switch (step.type)
+	{
+	case MOVE:
+	case REMOVE:
+		fs::rename(step.from, asidePath, ec);
+		break;
+	case COPY:
+	{
+		ifstream f(step.from, ios::binary);
+		if (!f)
+		{
+			SDL_Log("Failed to open '%s'\n", step.from.generic_string().c_str());
+			return false;
+		}
+		const vector<Uint8> data((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+		return SaveTransaction::writeFileSynced(asidePath, data);
+	}
+	case WRITE:
+		return SaveTransaction::writeFileSynced(asidePath, step.data);
+	}
+
+	if (ec)
+		SDL_Log("Failed to move '%s' aside\n", step.from.generic_string().c_str());
+	return !ec;
+}
+
+void MoveTransaction::putBack(const Step &step)
+{
+	error_code ec;
+	const fs::path asidePath = MoveTransaction::asidePath(step);
+	if (!fs::exists(asidePath, ec))
+		return;
+
+	if (step.type == MOVE || step.type == REMOVE)
+		fs::rename(asidePath, step.from, ec);
+	else
+		fs::remove(asidePath, ec);
+
+	if (ec)
+		SDL_Log("Failed to put back '%s', it was left as '%s'\n", step.from.generic_string().c_str(), asidePath.generic_string().c_str());
+}
+
+bool MoveTransaction::finish(const Step &step)
+{
+	error_code ec;
+	const fs::path asidePath = MoveTransaction::asidePath(step);
+	if (!fs::exists(asidePath, ec))
+		return true; // already finished
+
+	if (step.type == REMOVE)
+	{
+		fs::remove(asidePath, ec);
+		return !ec;
+	}
+
+	if (step.levelId >= 0 && !setDatId(asidePath, step.levelId))
+		return false;
+	fs::rename(asidePath, step.to, ec);
+	if (ec)
+	{
+		SDL_Log("Failed to move '%s' into place\n", step.to.generic_string().c_str());
+		return false;
+	}
+	return true;
+}
+
+bool MoveTransaction::commit(void)
+{
+	// Each target may only be filled once, and anything already there that isn't moving away is set aside
+	set<fs::path> leaving, arriving;
+	for (vector<Step>::const_iterator i = steps.begin(); i != steps.end(); ++i)
+	{
+		if (i->type == MOVE || i->type == REMOVE)
+			leaving.insert(i->from);
+		if (i->type != REMOVE && !arriving.insert(i->to).second)
+		{
+			SDL_Log("MoveTransaction: '%s' is the target of more than one file\n", i->to.generic_string().c_str());
+			return false;
+		}
+	}
+
+	error_code ec;
+	for (set<fs::path>::const_iterator i = arriving.begin(); i != arriving.end(); ++i)
+		if (leaving.count(*i) == 0 && fs::exists(*i, ec))
+			remove(*i);
+
+	// Copies go first so a source that is also being replaced is still there to read
+	stable_partition(steps.begin(), steps.end(), [](const Step &step) { return step.type == COPY; });
+
+	if (steps.empty())
+		return true;
+	if (!writeJournal(folder, steps, false))
+		return false;
+
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		if (!aside(steps[i]))
+		{
+			while (i-- > 0)
+				putBack(steps[i]);
+			SaveTransaction::syncFolder(folder);
+			fs::remove(journalPath(folder), ec);
+			return false;
+		}
+	}
+	SaveTransaction::syncFolder(folder);
+
+	if (!writeJournal(folder, steps, true))
+	{
+		for (vector<Step>::reverse_iterator i = steps.rbegin(); i != steps.rend(); ++i)
+			putBack(*i);
+		SaveTransaction::syncFolder(folder);
+		fs::remove(journalPath(folder), ec);
+		return false;
+	}
+
+	// From here on the batch counts as done, anything left unfinished is finished by recover()
+	for (vector<Step>::const_iterator i = steps.begin(); i != steps.end(); ++i)
+	{
+		if (!finish(*i))
+		{
+			SDL_Log("MoveTransaction: Stopped part way, it will be finished on the next load\n");
+			return false;
+		}
+	}
+	SaveTransaction::syncFolder(folder);
+
+	fs::remove(journalPath(folder), ec);
+	steps.clear();
+	return true;
+}
+
+void MoveTransaction::recover(const fs::path folder)
+{
+	error_code ec;
+	const fs::path journalFile = journalPath(folder);
+	fs::remove(SaveTransaction::stagedPath(journalFile), ec);
+	if (!fs::exists(journalFile, ec))
+		return;
+
+	ifstream f(journalFile);
+	string state, line;
+	getline(f, state);
+	vector<Step> steps;
+	while (getline(f, line))
+	{
+		istringstream fields(line);
+		string type, id, from, to;
+		if (!getline(fields, type, '\t') || !getline(fields, id, '\t') || !getline(fields, from, '\t') || type.size() != 1)
+			continue;
+		getline(fields, to);
+		steps.push_back({ (stepType)type[0], from, to, atoi(id.c_str()), vector<Uint8>() });
+	}
+	f.close();
+
+	if (state == "COMMITTED")
+	{
+		// Roll forward, every file was set aside before the journal was marked
+		for (vector<Step>::const_iterator i = steps.begin(); i != steps.end(); ++i)
+		{
+			if (!finish(*i))
+			{
+				SDL_Log("recover: Failed to finish interrupted renumbering\n");
+				return;
+			}
+		}
+		SDL_Log("recover: Finished interrupted renumbering in '%s'\n", folder.generic_string().c_str());
+	}
+	else
+	{
+		// Roll back, nothing had reached its new name yet
+		for (vector<Step>::reverse_iterator i = steps.rbegin(); i != steps.rend(); ++i)
+			putBack(*i);
+		SDL_Log("recover: Undid interrupted renumbering in '%s'\n", folder.generic_string().c_str());
+	}
+	SaveTransaction::syncFolder(folder);
+	fs::remove(journalFile, ec);
+}
@@ -0,0 +1,114 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef TRANSACTION_HPP
+#define TRANSACTION_HPP
+
+#include "SDL.h"
+
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+// Replaces a group of files in one folder so that either all or none of them change.
+// Each file is written and synced next to its target first, then a journal listing them is
+// written before they are renamed into place. If that is interrupted, recover() finishes
+// the renames when a journal exists, or throws the half written files away when it doesn't.
+class SaveTransaction
+{
+public:
+	SaveTransaction(const fs::path folder);
+	~SaveTransaction(void);
+
+	bool add(const fs::path target, const std::vector<Uint8> &data);
+	bool commit(void);
+
+	// Call before reading from a folder that may have been saved to
+	static void recover(const fs::path folder);
+
+	static bool writeFileSynced(const fs::path filename, const std::vector<Uint8> &data);
+
+private:
+	fs::path folder;
+	std::vector<fs::path> targets;
+	bool committed;
+
+	void abort(void);
+
+	static fs::path journalPath(const fs::path folder);
+	static fs::path stagedPath(const fs::path target);
+	static void syncFolder(const fs::path folder);
+
+	friend class MoveTransaction;
+};
+
+// Renames, copies and deletes a group of files in one folder as a single step, used to
+// renumber levels. Every file is first moved aside to a temporary name, so swaps and longer
+// reorders need no spare ids and anything already at a target survives until the end. A
+// failure while moving aside puts everything back, once all files are aside a journal marks
+// the batch as committed and recover() finishes it after a crash.
+class MoveTransaction
+{
+public:
+	MoveTransaction(const fs::path folder);
+
+	void move(const fs::path from, const fs::path to);
+	void copy(const fs::path from, const fs::path to);
+	void write(const fs::path target, const std::vector<Uint8> &data);
+	void remove(const fs::path target);
+	// The DAT ending up at target gets its TEMP and PERM references set to id
+	void setLevelId(const fs::path target, int id);
+
+	// Moves the LEVEL, TEMP and PERM files of one id to another, does nothing when they match
+	void moveLevel(int from, int to);
+	void removeLevel(int id);
+
+	bool commit(void);
+
+	// Called by SaveTransaction::recover
+	static void recover(const fs::path folder);
+
+private:
+	enum stepType { MOVE = 'M', COPY = 'C', WRITE = 'W', REMOVE = 'R' };
+
+	class Step
+	{
+	public:
+		stepType type;
+		fs::path from; // empty for WRITE
+		fs::path to; // empty for REMOVE
+		int levelId; // -1 unless setLevelId was called for to
+		std::vector<Uint8> data; // WRITE only
+	};
+
+	fs::path folder;
+	std::vector<Step> steps;
+
+	static bool aside(const Step &step);
+	static void putBack(const Step &step);
+	static bool finish(const Step &step);
+
+	static fs::path asidePath(const Step &step);
+	static fs::path journalPath(const fs::path folder);
+	static bool writeJournal(const fs::path folder, const std::vector<Step> &steps, bool committed);
+	static bool setDatId(const fs::path datPath, int id);
+};
+
+#endif // TRANSACTION_HPP
@@ -0,0 +1,241 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for checking levels for problems from the command line
+ */
+
+#include "batch.hpp"
+#include "lem3edit.hpp"
+#include "level.hpp"
+#include "parallel.hpp"
+#include "style.hpp"
+#include "validate.hpp"
+
+#include "SDL.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <experimental/filesystem>
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+static string format(const char *fmt, ...)
+{
+	char buffer[256];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+	return buffer;
+}
+
+bool Validate::validatePath(const fs::path dataPath, const fs::path path, const fs::path outPath)
+{
+	LevelBatch batch;
+	if (!batch.find(path))
+		return false;
+
+	batch.loadLevels();
+	batch.loadStyles(dataPath);
+
+	vector<Report> reports(batch.items.size());
+	parallel_for(batch.items.size(), [&](int i)
+	{
+		checkLevel(batch, i, reports[i]);
+	});
+
+	int errorCount = 0;
+	int warningCount = 0;
+	ostringstream json;
+	json << "{\n\t\"path\": \"" << escapeJSON(path.generic_string()) << "\",\n\t\"levels\": [";
+	for (unsigned int i = 0; i < batch.items.size(); ++i)
+	{
+		const LevelBatch::Item &item = batch.items[i];
+		const Report &report = reports[i];
+		errorCount += report.errors.size();
+		warningCount += report.warnings.size();
+
+		json << (i == 0 ? "\n" : ",\n");
+		json << "\t\t{ \"id\": " << item.id << ", \"name\": \"" << escapeJSON(item.name) << "\", \"errors\": [";
+		for (unsigned int j = 0; j < report.errors.size(); ++j)
+			json << (j == 0 ? "" : ", ") << "\"" << escapeJSON(report.errors[j]) << "\"";
+		json << "], \"warnings\": [";
+		for (unsigned int j = 0; j < report.warnings.size(); ++j)
+			json << (j == 0 ? "" : ", ") << "\"" << escapeJSON(report.warnings[j]) << "\"";
+		json << "] }";
+	}
+	json << "\n\t],\n\t\"levelCount\": " << batch.items.size() << ",\n\t\"errorCount\": " << errorCount << ",\n\t\"warningCount\": " << warningCount << "\n}\n";
+
+	if (outPath.empty())
+	{
+		cout << json.str();
+		cout.flush();
+	}
+	else
+	{
+		ofstream f(outPath, ios::trunc);
+		if (!f)
+		{
+			SDL_Log("validatePath: Failed to open '%s'\n", outPath.generic_string().c_str());
+			return false;
+		}
+		f << json.str();
+	}
+
+	SDL_Log("Validated %d levels: %d errors, %d warnings\n", (int)batch.items.size(), errorCount, warningCount);
+	return errorCount == 0;
+}
+
+void Validate::checkLevel(const LevelBatch &batch, int i, Report &report)
+{
+	const LevelBatch::Item &item = batch.items[i];
+
+	// The same files PackEditor::levelExists looks for
+	if (!batch.fileExists("LEVEL", item.id, "DAT"))
+	{
+		report.errors.push_back(format("LEVEL%03d.DAT is missing", item.id));
+		return;
+	}
+	if (batch.fileSize("LEVEL", item.id, "DAT") != Level::DAT_SIZE)
+		report.errors.push_back(format("LEVEL%03d.DAT is %d bytes, expected %d", item.id, (int)batch.fileSize("LEVEL", item.id, "DAT"), Level::DAT_SIZE));
+
+	const Level &level = *item.level;
+
+	// Level::load reads the header before the objects, so temp and perm are valid even if it failed
+	const char *obsNames[2] = { "PERM", "TEMP" };
+	const int obsIds[2] = { level.perm, level.temp };
+	for (int t = 0; t < 2; ++t)
+	{
+		if (obsIds[t] != item.id)
+		{
+			if (item.inPack)
+				report.errors.push_back(format("Header uses %s%03d.OBS but levels in a pack must use their own id %d", obsNames[t], obsIds[t], item.id));
+			else
+				report.warnings.push_back(format("Header uses %s%03d.OBS which doesn't match the level id %d", obsNames[t], obsIds[t], item.id));
+		}
+		if (!batch.fileExists(obsNames[t], obsIds[t], "OBS"))
+			report.errors.push_back(format("%s%03d.OBS is missing", obsNames[t], obsIds[t]));
+		else if (batch.fileSize(obsNames[t], obsIds[t], "OBS") % Level::OBS_RECORD_SIZE != 0)
+			report.warnings.push_back(format("%s%03d.OBS has a truncated object record", obsNames[t], obsIds[t]));
+	}
+
+	if (!item.loaded)
+	{
+		report.errors.push_back("Level couldn't be loaded");
+		return;
+	}
+
+	if (!((level.tribe == 4 && level.style == 1) ||
+		(level.tribe == 10 && level.style == 2) ||
+		(level.tribe == 5 && level.style == 3)))
+		report.warnings.push_back(format("Tribe %d and style %d aren't a standard pair", level.tribe, level.style));
+
+	if (item.inPack &&
+		!((item.tribe == CLASSIC && level.tribe == 4) ||
+		(item.tribe == SHADOW && level.tribe == 10) ||
+		(item.tribe == EGYPT && level.tribe == 5)))
+		report.errors.push_back(format("Tribe %d doesn't match the pack tab the level is in", level.tribe));
+
+	if (level.width < 320 || level.width > 2048 || level.width % 8 != 0)
+		report.errors.push_back(format("Width %d must be a multiple of 8 from 320 to 2048", level.width));
+	if (level.height < 160 || level.height > 400 || level.height % 4 != 0)
+		report.errors.push_back(format("Height %d must be a multiple of 4 from 160 to 400", level.height));
+	if (level.cameraX < 0 || level.cameraX + 320 > level.width ||
+		level.cameraY < 0 || level.cameraY + 160 > level.height)
+		report.errors.push_back(format("Camera %d, %d is outside the level", level.cameraX, level.cameraY));
+
+	if (level.release_rate > 999)
+		report.errors.push_back(format("Release rate %d is above 999", level.release_rate));
+	if (level.release_delay > 999)
+		report.errors.push_back(format("Release delay %d is above 999", level.release_delay));
+	if (level.time > 420)
+		report.errors.push_back(format("Time limit %d is above 420 seconds", level.time));
+
+	// The game takes these counts from the header, Level::save_objects recounts them from the tools
+	int extraLemmings = 0;
+	int enemies = 0;
+	for (vector<Level::Object>::const_iterator o = level.object[TOOL].begin(); o != level.object[TOOL].end(); ++o)
+	{
+		if (o->isExtraLemming())
+			extraLemmings++;
+		if (o->isEnemy())
+			enemies++;
+	}
+	if (extraLemmings != level.extra_lemmings)
+		report.errors.push_back(format("Header has %d extra lemmings but there are %d in the level", level.extra_lemmings, extraLemmings));
+	if (enemies != level.enemies)
+		report.errors.push_back(format("Header has %d enemies but there are %d in the level", level.enemies, enemies));
+
+	if (batch.style(level.style) == NULL)
+	{
+		report.errors.push_back(format("Style %d couldn't be loaded, objects weren't checked", level.style));
+		return;
+	}
+
+	// The same checks Level::validate makes when saving, objects that fail are dropped from the saved level
+	const char *layerNames[3] = { "PERM", "TEMP", "TOOL" };
+	for (int type = 0; type < 3; ++type)
+	{
+		for (vector<Level::Object>::const_iterator o = level.object[type].begin(); o != level.object[type].end(); ++o)
+		{
+			switch (level.check_object(&*o, type))
+			{
+			case Level::OBJECT_INVALID_ID:
+				if (o->id == 10008 || o->id == 10009)
+					report.errors.push_back(format("%s object %d at %d, %d crashes the game", layerNames[type], o->id, level.objectX(*o), level.objectY(*o)));
+				else
+					report.errors.push_back(format("%s object %d at %d, %d has an invalid id", layerNames[type], o->id, level.objectX(*o), level.objectY(*o)));
+				break;
+			case Level::OBJECT_OUTSIDE_BORDER:
+				report.warnings.push_back(format("%s object %d at %d, %d is outside the level and will be dropped on save", layerNames[type], o->id, level.objectX(*o), level.objectY(*o)));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+string Validate::escapeJSON(const string &s)
+{
+	string out;
+	for (string::const_iterator c = s.begin(); c != s.end(); ++c)
+	{
+		switch (*c)
+		{
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if ((unsigned char)*c < 0x20)
+				out += format("\\u%04x", (unsigned char)*c);
+			else
+				out += *c;
+		}
+	}
+	return out;
+}
@@ -0,0 +1,51 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef VALIDATE_HPP
+#define VALIDATE_HPP
+
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+class LevelBatch;
+
+class Validate
+{
+public:
+	class Report
+	{
+	public:
+		std::vector<std::string> errors;
+		std::vector<std::string> warnings;
+	};
+
+	// Checks every level in a pack or folder and writes the results as JSON to outPath, or stdout if empty
+	// Returns false if any level has errors
+	static bool validatePath(const fs::path dataPath, const fs::path path, const fs::path outPath);
+
+	static void checkLevel(const LevelBatch &batch, int i, Report &report);
+
+private:
+	static std::string escapeJSON(const std::string &s);
+};
+
+#endif // VALIDATE_HPP
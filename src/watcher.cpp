@@ -0,0 +1,242 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+ /*
+ This file contains code for noticing when files are changed by other programs
+ */
+
+#include "watcher.hpp"
+
+#include "SDL.h"
+
+#include <algorithm>
+#include <experimental/filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::experimental::filesystem::v1;
+
+// How often the folders are listed when inotify isn't available, and how often the inotify wait checks for stop
+#define POLL_INTERVAL 1000
+#define INOTIFY_WAIT 250
+
+FileWatcher::FileWatcher(void) : worker(NULL), mutex(NULL), wake(NULL), quitting(false)
+{
+	/* nothing to do */
+}
+
+FileWatcher::~FileWatcher(void)
+{
+	stop();
+}
+
+void FileWatcher::start(const vector<fs::path> &folders)
+{
+	stop();
+
+	// the level and pack are often in the same folder
+	this->folders.clear();
+	for (vector<fs::path>::const_iterator i = folders.begin(); i != folders.end(); ++i)
+	{
+		if (find(this->folders.begin(), this->folders.end(), *i) == this->folders.end())
+			this->folders.push_back(*i);
+	}
+
+	quitting = false;
+	pending.clear();
+	mutex = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	worker = SDL_CreateThread(workerMain, "watcher", this);
+	if (worker == NULL)
+		SDL_Log("FileWatcher: Couldn't start worker thread: %s\n", SDL_GetError());
+}
+
+void FileWatcher::stop(void)
+{
+	if (worker == NULL)
+		return;
+
+	SDL_LockMutex(mutex);
+	quitting = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(mutex);
+	SDL_WaitThread(worker, NULL);
+	worker = NULL;
+
+	SDL_DestroyCond(wake);
+	SDL_DestroyMutex(mutex);
+	wake = NULL;
+	mutex = NULL;
+}
+
+bool FileWatcher::takeChanges(set<fs::path> &changed)
+{
+	if (worker == NULL)
+		return false;
+
+	SDL_LockMutex(mutex);
+	bool any = !pending.empty();
+	if (any)
+	{
+		changed.insert(pending.begin(), pending.end());
+		pending.clear();
+	}
+	SDL_UnlockMutex(mutex);
+	return any;
+}
+
+void FileWatcher::changed(const fs::path &file)
+{
+	SDL_LockMutex(mutex);
+	pending.insert(file);
+	SDL_UnlockMutex(mutex);
+}
+
+bool FileWatcher::shouldQuit(void)
+{
+	SDL_LockMutex(mutex);
+	bool q = quitting;
+	SDL_UnlockMutex(mutex);
+	return q;
+}
+
+int SDLCALL FileWatcher::workerMain(void *data)
+{
+	FileWatcher *watcher = (FileWatcher *)data;
+	if (!watcher->watchInotify())
+		watcher->watchPolling();
+	return 0;
+}
+
+// Returns false straight away if inotify can't be used, so polling takes over
+bool FileWatcher::watchInotify(void)
+{
+#ifdef __linux__
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	map<int, fs::path> watches;
+	for (vector<fs::path>::const_iterator i = folders.begin(); i != folders.end(); ++i)
+	{
+		int wd = inotify_add_watch(fd, i->c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
+		if (wd == -1)
+		{
+			SDL_Log("FileWatcher: Couldn't watch '%s' with inotify, polling instead\n", i->generic_string().c_str());
+			close(fd);
+			return false;
+		}
+		watches[wd] = *i;
+	}
+
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	while (!shouldQuit())
+	{
+		struct pollfd p = { fd, POLLIN, 0 };
+		if (poll(&p, 1, INOTIFY_WAIT) <= 0)
+			continue;
+
+		ssize_t length;
+		while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char *ptr = buffer; ptr < buffer + length; )
+			{
+				const struct inotify_event *event = (const struct inotify_event *)ptr;
+				map<int, fs::path>::const_iterator folder = watches.find(event->wd);
+				if (folder != watches.end() && event->len > 0)
+					changed(folder->second / event->name);
+				ptr += sizeof(struct inotify_event) + event->len;
+			}
+		}
+	}
+
+	close(fd);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FileWatcher::watchPolling(void)
+{
+	Listing before, after;
+	list(before);
+
+	SDL_LockMutex(mutex);
+	while (!quitting)
+	{
+		SDL_CondWaitTimeout(wake, mutex, POLL_INTERVAL);
+		if (quitting)
+			break;
+		SDL_UnlockMutex(mutex);
+
+		after.clear();
+		list(after);
+
+		// anything new, different or gone
+		for (Listing::const_iterator i = after.begin(); i != after.end(); ++i)
+		{
+			Listing::const_iterator old = before.find(i->first);
+			if (old == before.end() || old->second != i->second)
+				changed(i->first);
+		}
+		for (Listing::const_iterator i = before.begin(); i != before.end(); ++i)
+		{
+			if (after.find(i->first) == after.end())
+				changed(i->first);
+		}
+		before.swap(after);
+
+		SDL_LockMutex(mutex);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+void FileWatcher::list(Listing &listing) const
+{
+	for (vector<fs::path>::const_iterator folder = folders.begin(); folder != folders.end(); ++folder)
+	{
+		error_code ec;
+		fs::directory_iterator iter(*folder, ec);
+		if (ec)
+			continue;
+
+		for (; iter != fs::directory_iterator(); iter.increment(ec))
+		{
+			if (ec)
+				break;
+
+			uintmax_t size = fs::file_size(iter->path(), ec);
+			if (ec)
+			{
+				ec.clear();
+				continue; // not a regular file
+			}
+			Sint64 time = fs::last_write_time(iter->path(), ec).time_since_epoch().count();
+			ec.clear();
+			listing[iter->path()] = make_pair(size, time);
+		}
+	}
+}
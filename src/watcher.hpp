@@ -0,0 +1,72 @@
+/*
+ * lem3edit
+ * Copyright (C) 2008-2009 Carl Reinke
+ * Copyright (C) 2017-2018 Kieran Millar
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include "SDL.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem::v1;
+
+// Watches a few folders on a worker thread and collects the files that change in them,
+// using inotify where there is one and otherwise listing the folders every so often
+class FileWatcher
+{
+public:
+	// Starting again replaces whatever was being watched
+	void start(const std::vector<fs::path> &folders);
+	void stop(void);
+	bool watching(void) const { return worker != NULL; }
+
+	// Moves the files changed since the last call into changed, returns false if there were none
+	bool takeChanges(std::set<fs::path> &changed);
+
+	FileWatcher(void);
+	~FileWatcher(void);
+
+private:
+	std::vector<fs::path> folders;
+
+	SDL_Thread *worker;
+	SDL_mutex *mutex;
+	SDL_cond *wake;
+	bool quitting;
+	std::set<fs::path> pending; // guarded by mutex
+
+	// size and last write time of every file, for polling
+	typedef std::map< fs::path, std::pair<uintmax_t, Sint64> > Listing;
+
+	void changed(const fs::path &file);
+	bool shouldQuit(void);
+	bool watchInotify(void);
+	void watchPolling(void);
+	void list(Listing &listing) const;
+
+	static int SDLCALL workerMain(void *data);
+
+	FileWatcher(const FileWatcher &);
+	FileWatcher & operator=(const FileWatcher &);
+};
+
+#endif // WATCHER_HPP